@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cmath>
+#include <queue>
+#include <vector>
+#include "quadrature.hpp"
+
+#define ADAPTIVE_SIMPSON_MAX_DEPTH 50
+#define GAUSS_KRONROD_MAX_INTERVALS 2000
+
+/**
+ * Outcome of an adaptive integration: the integral, its estimated absolute error, how many
+ * times the integrand was evaluated and whether the requested tolerance was met.
+ */
+struct QuadratureResult {
+    double value = 0;
+    double error = 0;
+    long long evaluations = 0;
+    bool converged = true;
+};
+
+template<Integrand F>
+double adaptiveSimpsonStep(F &f, double a, double b, double fa, double fm, double fb, double whole,
+                           double tolerance, int depth, QuadratureResult &result) {
+    double m = (a + b) / 2, lm = (a + m) / 2, rm = (m + b) / 2;
+    double flm = f(lm), frm = f(rm);
+    result.evaluations += 2;
+
+    double left = (m - a) / 6 * (fa + 4 * flm + fm);
+    double right = (b - m) / 6 * (fm + 4 * frm + fb);
+    double delta = left + right - whole;
+
+    // |delta| / 15 estimates the error of the refined pair, see Lyness (1969)
+    if (std::abs(delta) <= 15 * tolerance || depth <= 0) {
+        result.error += std::abs(delta) / 15;
+        return left + right + delta / 15;
+    }
+
+    return adaptiveSimpsonStep(f, a, m, fa, flm, fm, left, tolerance / 2, depth - 1, result) +
+           adaptiveSimpsonStep(f, m, b, fm, frm, fb, right, tolerance / 2, depth - 1, result);
+}
+
+/**
+ * @brief Integrates f from a to b with adaptive Simpson's rule.
+ *
+ * Each panel is split in half until the two halves agree with the whole to within the panel's
+ * share of the tolerance, so points are only added where the integrand needs them.
+ *
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param tolerance - the absolute error to reach
+ * @return the integral, error estimate and evaluation count
+ */
+template<Integrand F>
+QuadratureResult adaptiveSimpson(F &&f, double a, double b, double tolerance) {
+    QuadratureResult result;
+
+    double fa = f(a), fm = f((a + b) / 2), fb = f(b);
+    result.evaluations = 3;
+
+    double whole = (b - a) / 6 * (fa + 4 * fm + fb);
+    result.value = adaptiveSimpsonStep(f, a, b, fa, fm, fb, whole, tolerance, ADAPTIVE_SIMPSON_MAX_DEPTH, result);
+
+    // panels cut off at the depth limit only matter if they push the total over the tolerance
+    result.converged = result.error <= tolerance;
+
+    return result;
+}
+
+/**
+ * 15 point Kronrod extension of the 7 point Gauss-Legendre rule on [-1, 1]. Nodes are listed
+ * from the outside in, the odd ones are the Gauss nodes.
+ */
+constexpr double kronrodNodes[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+constexpr double kronrodWeights[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+constexpr double gaussWeights[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+struct KronrodInterval {
+    double a, b, value, error;
+
+    bool operator<(const KronrodInterval &other) const {
+        return error < other.error;
+    }
+};
+
+/**
+ * @brief Applies the G7-K15 pair to [a, b]; the error estimate is |K15 - G7|.
+ */
+template<Integrand F>
+KronrodInterval gaussKronrod15Interval(F &f, double a, double b) {
+    double c = (a + b) / 2, r = (b - a) / 2;
+    double x[15], y[15];
+
+    for (int k = 0; k < 7; ++k) {
+        x[2 * k] = c - r * kronrodNodes[k];
+        x[2 * k + 1] = c + r * kronrodNodes[k];
+    }
+    x[14] = c;
+    evalPoints(f, x, y, 15);
+
+    double kronrod = kronrodWeights[7] * y[14];
+    double gauss = gaussWeights[3] * y[14];
+    for (int k = 0; k < 7; ++k) {
+        kronrod += kronrodWeights[k] * (y[2 * k] + y[2 * k + 1]);
+        if (k % 2)
+            gauss += gaussWeights[k / 2] * (y[2 * k] + y[2 * k + 1]);
+    }
+
+    return {a, b, kronrod * r, std::abs(kronrod - gauss) * r};
+}
+
+/**
+ * @brief Integrates f from a to b with globally adaptive G7-K15 quadrature.
+ *
+ * The interval with the largest error estimate is bisected until the summed estimate drops
+ * below the tolerance, in the manner of QUADPACK's QAG. Batch integrands get all 15 nodes of
+ * an interval in one call.
+ *
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param tolerance - the absolute error to reach
+ * @return the integral, error estimate and evaluation count
+ */
+template<Integrand F>
+QuadratureResult gaussKronrod15(F &&f, double a, double b, double tolerance) {
+    QuadratureResult result;
+    std::priority_queue<KronrodInterval> intervals;
+
+    KronrodInterval whole = gaussKronrod15Interval(f, a, b);
+    intervals.push(whole);
+    result.value = whole.value;
+    result.error = whole.error;
+    result.evaluations = 15;
+
+    while (result.error > tolerance) {
+        if (intervals.size() >= GAUSS_KRONROD_MAX_INTERVALS)
+            break;
+
+        KronrodInterval worst = intervals.top();
+        intervals.pop();
+
+        double m = (worst.a + worst.b) / 2;
+        KronrodInterval left = gaussKronrod15Interval(f, worst.a, m);
+        KronrodInterval right = gaussKronrod15Interval(f, m, worst.b);
+        result.evaluations += 30;
+
+        result.value += left.value + right.value - worst.value;
+        result.error += left.error + right.error - worst.error;
+        intervals.push(left);
+        intervals.push(right);
+    }
+
+    // re-add from scratch, the running updates above accumulate rounding
+    result.value = 0;
+    result.error = 0;
+    for (; !intervals.empty(); intervals.pop()) {
+        result.value += intervals.top().value;
+        result.error += intervals.top().error;
+    }
+    result.converged = result.error <= tolerance;
+
+    return result;
+}
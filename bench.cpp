@@ -0,0 +1,1066 @@
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include "dual.hpp"
+#include "lab_01.hpp"
+#include "loader.hpp"
+#include "monte_carlo.hpp"
+#include "pbPlot/pbPlots.hpp"
+#include "portfolio.hpp"
+#include "risk.hpp"
+#include "sensitivity.hpp"
+#include "cubature.hpp"
+#include "quadrature.hpp"
+#include "quadrature_tables.hpp"
+#include "romberg.hpp"
+#include "sweep.hpp"
+
+using namespace std;
+
+/**
+ * Command line options, after Google Benchmark's flags:
+ *
+ *   --format=console|json|csv  how the suite is reported, the reports only run with console
+ *   --out=<file>               write the suite there instead of to stdout
+ *   --filter=<regex>           only run suite entries and reports whose name matches
+ *   --min_time=<seconds>       minimum time each timed entry runs for
+ *   --selftest                 run the correctness checks instead, exit status 1 if any fails
+ */
+struct BenchOptions {
+    string format = "console";
+    string out;
+    string filter = ".*";
+    double minTime = 0.2;
+    bool selfTest = false;
+};
+
+/**
+ * One entry of the suite. `kind` is "time" for a timed integration at fixed n and "tolerance"
+ * for the smallest run that reaches a relative error, in which case n and evaluations are the
+ * cost of that run (-1 if it was not reached).
+ */
+struct BenchRecord {
+    string name;
+    string kind;
+    string rule;
+    string integrand;
+    string cost;
+    string summation;
+    long long n = 0;
+    double tolerance = 0;
+    long long evaluations = 0;
+    long long iterations = 0;
+    double nsPerEval = 0;
+    double relativeError = 0;
+};
+
+double minTime = 0.2;
+
+/**
+ * @brief Runs `integrate` repeatedly for at least the minimum time and returns the time per integrand evaluation.
+ *
+ * @param evaluations - integrand evaluations made by one call of `integrate`
+ * @param integrate - the integration to time
+ * @param iterations - if given, set to the number of calls made
+ * @return nanoseconds per evaluation
+ */
+double timePerEval(long long evaluations, auto integrate, long long *iterations = nullptr) {
+    using clock = chrono::steady_clock;
+
+    volatile double sink = 0;
+    long long repeats = 0;
+    auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+
+    while (elapsed < chrono::duration<double>(minTime)) {
+        sink = sink + integrate();
+        ++repeats;
+        elapsed = clock::now() - start;
+    }
+
+    if (iterations)
+        *iterations = repeats;
+    return chrono::duration<double, nano>(elapsed).count() / (repeats * evaluations);
+}
+
+/**
+ * @brief Runs the suite for one integrand: every rule, summation mode and n, then the evaluations
+ * each rule needs to reach each tolerance.
+ *
+ * @param f - the integrand
+ * @param name - its name in the records
+ * @param cost - its cost class
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param filter - entries whose name does not match are skipped
+ * @param records - where the results are appended
+ */
+template<Integrand F>
+void suiteFor(F f, const string &name, const string &cost, double a, double b, const regex &filter,
+              vector<BenchRecord> &records) {
+    struct Mode {
+        const char *name;
+        Summation summation;
+    } modes[] = {{"naive", Summation::Naive}, {"pairwise", Summation::Pairwise},
+                 {"kahan", Summation::KahanNeumaier}};
+    double exact = F::exact(a, b);
+
+    // volatile bounds keep the compiler from hoisting the integration out of the timing loop
+    volatile double lower = a, upper = b;
+    auto integrate = [&](const string &rule, int n, Summation summation) {
+        return rule == "trapezoidal" ? trapezoidal(n, f, lower, upper, summation)
+                                     : simpsons(n, f, lower, upper, summation);
+    };
+
+    for (string rule: {"trapezoidal", "simpsons"})
+        for (auto &mode: modes) {
+            // At n = 1e8 the truncation error is far below double precision, so what remains is rounding
+            for (int n: {100, 10000, 1000000, 100000000}) {
+                BenchRecord record{rule + "/" + name + "/" + mode.name + "/n:" + to_string(n), "time", rule, name, cost,
+                                   mode.name, n};
+                if (!regex_search(record.name, filter))
+                    continue;
+
+                auto run = [&] { return integrate(rule, n, mode.summation); };
+                record.evaluations = n + 1;
+                record.nsPerEval = timePerEval(n + 1, run, &record.iterations);
+                record.relativeError = abs(run() - exact) / abs(exact);
+                records.push_back(record);
+            }
+
+            for (double tolerance: {1e-6, 1e-10}) {
+                ostringstream label;
+                label << "to_tolerance/" << rule << "/" << name << "/" << mode.name << "/tol:" << tolerance;
+                BenchRecord record{label.str(), "tolerance", rule, name, cost, mode.name, -1, tolerance, -1};
+                if (!regex_search(record.name, filter))
+                    continue;
+
+                // double n until the error is reached, then time that run
+                for (int n = 2; n <= 1 << 26; n *= 2) {
+                    record.relativeError = abs(integrate(rule, n, mode.summation) - exact) / abs(exact);
+                    if (record.relativeError <= tolerance) {
+                        record.n = n;
+                        record.evaluations = n + 1;
+                        record.nsPerEval = timePerEval(n + 1, [&] { return integrate(rule, n, mode.summation); },
+                                                       &record.iterations);
+                        break;
+                    }
+                }
+                records.push_back(record);
+            }
+        }
+
+    // the adaptive rules reach a tolerance by themselves
+    for (double tolerance: {1e-6, 1e-10}) {
+        struct Adaptive {
+            const char *rule;
+            function<QuadratureResult()> integrate;
+        } adaptive[] = {
+                {"adaptive_simpson", [&] { return adaptiveSimpson(f, lower, upper, tolerance * abs(exact)); }},
+                {"gauss_kronrod15", [&] { return gaussKronrod15(f, lower, upper, tolerance * abs(exact)); }},
+                {"romberg", [&] { return Romberg(f, lower, upper).integrate(tolerance * abs(exact)); }},
+        };
+
+        for (auto &rule: adaptive) {
+            ostringstream label;
+            label << "to_tolerance/" << rule.rule << "/" << name << "/tol:" << tolerance;
+            BenchRecord record{label.str(), "tolerance", rule.rule, name, cost, "-", -1, tolerance, -1};
+            if (!regex_search(record.name, filter))
+                continue;
+
+            QuadratureResult result = rule.integrate();
+            record.relativeError = abs(result.value - exact) / abs(exact);
+            if (result.converged) {
+                record.evaluations = result.evaluations;
+                record.nsPerEval = timePerEval(result.evaluations, [&] { return rule.integrate().value; },
+                                               &record.iterations);
+            }
+            records.push_back(record);
+        }
+    }
+}
+
+/**
+ * @brief Writes the suite as a table for reading.
+ */
+void writeConsole(ostream &out, const vector<BenchRecord> &records) {
+    if (records.empty())
+        return;
+
+    out << left << setw(52) << "benchmark" << setw(12) << "n" << setw(14) << "evaluations" << setw(12)
+        << "iterations" << setw(12) << "ns/eval" << "relative error" << endl;
+    for (auto &r: records)
+        out << setw(52) << r.name << setw(12) << r.n << setw(14) << r.evaluations << setw(12) << r.iterations << fixed
+            << setprecision(3) << setw(12) << r.nsPerEval << scientific << setprecision(2) << r.relativeError << endl;
+}
+
+/**
+ * @brief A string as a JSON string literal: quotes, backslashes and control characters escaped.
+ */
+string jsonString(const string &text) {
+    ostringstream out;
+    out << '"';
+    for (unsigned char c: text) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (c == '\n')
+            out << "\\n";
+        else if (c == '\t')
+            out << "\\t";
+        else if (c < 0x20)
+            out << "\\u" << hex << setw(4) << setfill('0') << (int) c << dec << setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+    return out.str();
+}
+
+/**
+ * @brief A CSV field, quoted with doubled quotes when it holds a comma, a quote or a line break.
+ */
+string csvField(const string &text) {
+    if (text.find_first_of(",\"\r\n") == string::npos)
+        return text;
+
+    string quoted = "\"";
+    for (char c: text)
+        quoted += c == '"' ? "\"\"" : string(1, c);
+    return quoted + "\"";
+}
+
+/**
+ * @brief A number for JSON or CSV at full precision, null if it is NaN or infinite.
+ */
+string number(double x) {
+    if (!isfinite(x))
+        return "null";
+
+    ostringstream out;
+    out << setprecision(17) << x;
+    return out.str();
+}
+
+/**
+ * @brief Writes the suite as JSON, laid out like Google Benchmark's output: a context object and
+ * an array of benchmarks.
+ */
+void writeJson(ostream &out, const vector<BenchRecord> &records) {
+    time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"num_cpus\": " << thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\",\n"
+#else
+        << "    \"library_build_type\": \"debug\",\n"
+#endif
+        << "    \"min_time\": " << minTime << "\n  },\n  \"benchmarks\": [";
+
+    for (size_t i = 0; i < records.size(); ++i) {
+        auto &r = records[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(r.name) << ", \"kind\": " << jsonString(r.kind)
+            << ", \"rule\": " << jsonString(r.rule) << ", \"integrand\": " << jsonString(r.integrand)
+            << ", \"cost\": " << jsonString(r.cost) << ", \"summation\": " << jsonString(r.summation)
+            << ", \"n\": " << r.n << ", \"tolerance\": " << number(r.tolerance) << ", \"evaluations\": " << r.evaluations
+            << ", \"iterations\": " << r.iterations << ", \"ns_per_eval\": " << number(r.nsPerEval)
+            << ", \"relative_error\": " << number(r.relativeError) << "}";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+/**
+ * @brief Writes the suite as CSV with a header row.
+ */
+void writeCsv(ostream &out, const vector<BenchRecord> &records) {
+    out << "name,kind,rule,integrand,cost,summation,n,tolerance,evaluations,iterations,ns_per_eval,relative_error"
+        << endl;
+    for (auto &r: records)
+        out << csvField(r.name) << "," << csvField(r.kind) << "," << csvField(r.rule) << "," << csvField(r.integrand)
+            << "," << csvField(r.cost) << "," << csvField(r.summation) << "," << r.n << "," << number(r.tolerance)
+            << "," << r.evaluations << "," << r.iterations << "," << number(r.nsPerEval) << ","
+            << number(r.relativeError) << endl;
+}
+
+/**
+ * @brief Cost per evaluation of an integrand passed as a function pointer, an inlinable lambda and a batched functor.
+ */
+void reportCallOverhead() {
+    cout << left << setw(12) << "rule" << setw(6) << "f" << setw(10) << "n"
+         << setw(16) << "pointer ns/eval" << setw(16) << "inline ns/eval"
+         << setw(16) << "batch ns/eval" << "speedup" << endl;
+
+    for (int n: {100, 10000, 1000000}) {
+        // volatile bounds keep the compiler from hoisting the integration out of the timing loop
+        volatile double a1 = 1, b1 = 2, a2 = exp(1), b2 = 5;
+
+        // pointer: F::eval through a function pointer, inline: a lambda the template can inline,
+        // batch: the functor, whose batched eval is picked up by the BatchIntegrand overloads
+        struct Row {
+            const char *rule, *f;
+            double pointer, inlined, batch;
+        } rows[] = {
+                {"trapezoidal", "F1",
+                 timePerEval(n + 1, [&] { return trapezoidal(n, F1::eval, a1, b1); }),
+                 timePerEval(n + 1, [&] { return trapezoidal(n, [](double x) { return F1::eval(x); }, a1, b1); }),
+                 timePerEval(n + 1, [&] { return trapezoidal(n, F1(), a1, b1); })},
+                {"trapezoidal", "F2",
+                 timePerEval(n + 1, [&] { return trapezoidal(n, F2::eval, a2, b2); }),
+                 timePerEval(n + 1, [&] { return trapezoidal(n, [](double x) { return F2::eval(x); }, a2, b2); }),
+                 timePerEval(n + 1, [&] { return trapezoidal(n, F2(), a2, b2); })},
+                {"simpsons", "F1",
+                 timePerEval(n + 1, [&] { return simpsons(n, F1::eval, a1, b1); }),
+                 timePerEval(n + 1, [&] { return simpsons(n, [](double x) { return F1::eval(x); }, a1, b1); }),
+                 timePerEval(n + 1, [&] { return simpsons(n, F1(), a1, b1); })},
+                {"simpsons", "F2",
+                 timePerEval(n + 1, [&] { return simpsons(n, F2::eval, a2, b2); }),
+                 timePerEval(n + 1, [&] { return simpsons(n, [](double x) { return F2::eval(x); }, a2, b2); }),
+                 timePerEval(n + 1, [&] { return simpsons(n, F2(), a2, b2); })},
+        };
+
+        for (auto &row: rows)
+            cout << setw(12) << row.rule << setw(6) << row.f << setw(10) << n << fixed << setprecision(3)
+                 << setw(16) << row.pointer << setw(16) << row.inlined << setw(16) << row.batch
+                 << setprecision(2) << row.pointer / row.batch << "x" << endl;
+    }
+}
+
+/**
+ * @brief Fixed-order rules from the constexpr tables against the run-time n rules at the same node count.
+ */
+void reportFixedOrder() {
+    volatile double a1 = 1, b1 = 2;
+    double exact = F1::exact(1, 2);
+
+    cout << left << setw(26) << "rule (F1)" << setw(8) << "nodes" << setw(12) << "ns/call"
+         << "relative error" << endl;
+    auto row = [&](const char *name, int nodes, auto integrate) {
+        double ns = timePerEval(1, integrate);
+        cout << setw(26) << name << setw(8) << nodes << fixed << setprecision(1) << setw(12) << ns << scientific
+             << setprecision(2) << abs(integrate() - exact) / exact << endl;
+    };
+
+    row("simpsons(n = 48)", 49, [&] { return simpsons(48, F1(), a1, b1); });
+    row("SimpsonRule x 24", 49, [&] { return newtonCotes<SimpsonRule, 24>(F1(), a1, b1); });
+    row("SimpsonThreeEighths x 16", 49, [&] { return newtonCotes<SimpsonThreeEighthsRule, 16>(F1(), a1, b1); });
+    row("BooleRule x 12", 49, [&] { return newtonCotes<BooleRule, 12>(F1(), a1, b1); });
+    row("GaussLegendre<8> x 6", 48, [&] { return gaussLegendre<8, 6>(F1(), a1, b1); });
+}
+
+/**
+ * @brief 3D cubature over the unit cube: full Simpson tensor grids against Smolyak sparse grids.
+ */
+void reportCubature() {
+    ThreadPool pool;
+    auto grade = [](const Point<3> &p) { return exp(p[0] + p[1] + p[2]); };
+    double exact = pow(exp(1) - 1, 3);
+
+    cout << left << setw(12) << "cubature" << setw(8) << "n/level" << setw(14) << "evaluations"
+         << setw(12) << "seconds" << "relative error" << endl;
+    auto row = [&](const char *name, int size, auto integrate) {
+        auto start = chrono::steady_clock::now();
+        CubatureResult result = integrate();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << setw(12) << name << setw(8) << size << setw(14) << result.evaluations << fixed << setprecision(4)
+             << setw(12) << seconds << scientific << setprecision(2) << abs(result.value - exact) / exact << endl;
+    };
+
+    for (int n: {16, 64, 256})
+        row("tensor", n, [&] { return tensorProduct<3>(n, simpsonsNodes, grade, {0, 0, 0}, {1, 1, 1}, &pool); });
+    for (int level: {4, 6, 8})
+        row("smolyak", level, [&] { return smolyak<3>(level, simpsonsNodes, grade, {0, 0, 0}, {1, 1, 1}, &pool); });
+}
+
+/**
+ * @brief Monte Carlo and quasi-Monte Carlo: evaluations and time to a relative standard error of 1e-4.
+ */
+void reportMonteCarlo() {
+    ThreadPool pool;
+    auto product = [](const Point<8> &p) {
+        double v = 1;
+        for (double x: p)
+            v *= M_PI / 2 * sin(M_PI * x);
+        return v;
+    };
+    Point<8> lower{}, upper;
+    upper.fill(1);
+
+    cout << left << setw(12) << "sampler" << setw(6) << "f" << setw(14) << "evaluations" << setw(12)
+         << "seconds" << setw(16) << "estimated error" << "actual error" << endl;
+    auto row = [&](const char *sampler, const char *f, auto integrate, double exact) {
+        auto start = chrono::steady_clock::now();
+        QuadratureResult result = integrate();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << setw(12) << sampler << setw(6) << f << setw(14) << result.evaluations << fixed << setprecision(4)
+             << setw(12) << seconds << scientific << setprecision(2) << setw(16) << result.error / abs(exact)
+             << abs(result.value - exact) / abs(exact) << (result.converged ? "" : " (not converged)") << endl;
+    };
+
+    struct {
+        const char *name;
+        Sampler sampler;
+    } samplers[] = {{"pseudo", Sampler::Pseudo}, {"halton", Sampler::Halton}, {"sobol", Sampler::Sobol}};
+    long long limit = 1 << 24;
+    for (auto &s: samplers) {
+        double e1 = F1::exact(1, 2), e2 = F2::exact(exp(1), 5);
+        row(s.name, "F1", [&] { return monteCarlo(F1(), 1, 2, s.sampler, 1e-4 * e1, limit, &pool); }, e1);
+        row(s.name, "F2", [&] { return monteCarlo(F2(), exp(1), 5, s.sampler, 1e-4 * e2, limit, &pool); }, e2);
+        row(s.name, "8D", [&] { return monteCarlo<8>(product, lower, upper, s.sampler, 1e-4, limit, &pool); }, 1);
+    }
+}
+
+/**
+ * @brief Parameter study: 1000 shifted copies of each problem, every rule and n from 10 to 1000, on 1 and all threads.
+ */
+void reportSweep() {
+    vector<SweepIntegrand> integrands;
+    for (int k = 0; k < 1000; ++k) {
+        double shift = k * 1e-3;
+        integrands.push_back({"F1+" + to_string(k), BatchFunction(F1()), 1 + shift, 2 + shift, 0});
+        integrands.push_back({"F2+" + to_string(k), BatchFunction(F2()), exp(1) + shift, 5 + shift, 0});
+    }
+    vector<int> ns;
+    for (int n = 10; n <= 1000; n += 10)
+        ns.push_back(n);
+
+    cout << left << setw(10) << "threads" << setw(12) << "tasks" << setw(12) << "seconds" << "speedup" << endl;
+    double serial = 0;
+    vector<unsigned> threadCounts = {1};
+    if (thread::hardware_concurrency() > 1)
+        threadCounts.push_back(thread::hardware_concurrency());
+    for (unsigned threads: threadCounts) {
+        ThreadPool pool(threads);
+        auto start = chrono::steady_clock::now();
+        auto results = runSweep({trapezoidalRule(), simpsonsRule()}, integrands, ns, pool);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (threads == 1)
+            serial = seconds;
+        cout << setw(10) << threads << setw(12) << results.size() << fixed << setprecision(3) << setw(12) << seconds
+             << setprecision(2) << serial / seconds << "x" << endl;
+    }
+}
+/**
+ * @brief Candidate blocks shaped like the four projects in main.cpp, with costs, revenues and
+ * rates scattered around them, for the portfolio reports.
+ *
+ * @param count - number of projects
+ * @param seed - seed of the scatter
+ */
+vector<Project<double>> syntheticProjects(size_t count, unsigned seed = 1) {
+    mt19937_64 random(seed);
+    uniform_real_distribution<double> scatter(0.8, 1.2), tax(30, 36), rate(12, 18);
+    vector<double> years = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    vector<double> operating = {0, 45, 35, 30, 32, 33, 36, 37, 38, 34, 35};
+    vector<double> revenue = {0, 80, 85, 75, 91, 95, 87, 95, 79, 81, 97};
+
+    vector<Project<double>> projects;
+    for (size_t i = 0; i < count; ++i) {
+        vector<double> op(years.size()), capex(years.size(), 0.0), rev(years.size());
+        for (size_t t = 0; t < years.size(); ++t) {
+            op[t] = operating[t] * scatter(random);
+            rev[t] = revenue[t] * scatter(random);
+        }
+        capex[0] = 200 * scatter(random);
+        projects.emplace_back("Block " + to_string(i), years, op, capex, rev, tax(random), rate(random));
+    }
+
+    return projects;
+}
+
+/**
+ * @brief NPV of 50k candidate blocks: one getNpv call per project against the portfolio engine.
+ */
+void reportPortfolio() {
+    auto projects = syntheticProjects(50000);
+    Portfolio portfolio;
+    for (auto &project: projects)
+        portfolio.add(project);
+
+    vector<double> npv(portfolio.size());
+    double worst = 0;
+    portfolio.npv(npv.data());
+    for (size_t p = 0; p < projects.size(); ++p)
+        worst = max(worst, abs(npv[p] - projects[p].getNpv()) / max(1.0, abs(npv[p])));
+
+    cout << left << setw(24) << "method" << setw(16) << "ns/project" << "speedup" << endl;
+    double perProject = timePerEval(projects.size(), [&] {
+        double sum = 0;
+        for (auto &project: projects)
+            sum += project.getNpv();
+        return sum;
+    });
+    cout << setw(24) << "Project::getNpv" << fixed << setprecision(2) << setw(16) << perProject << "1.00x" << endl;
+
+    ThreadPool pool;
+    struct {
+        const char *name;
+        ThreadPool *pool;
+    } runs[] = {{"Portfolio, 1 thread", nullptr}, {"Portfolio, pool", &pool}};
+    for (auto &run: runs) {
+        double ns = timePerEval(projects.size(), [&] {
+            portfolio.npv(npv.data(), run.pool);
+            return npv[0];
+        });
+        cout << setw(24) << run.name << setw(16) << ns << perProject / ns << "x" << endl;
+    }
+    cout << "largest difference to getNpv (float): " << scientific << setprecision(2) << worst << endl;
+}
+
+/**
+ * @brief IRR of 50k candidate blocks: Project::getIrr against the bracketed solver.
+ */
+void reportIrr() {
+    auto projects = syntheticProjects(50000);
+    Portfolio portfolio;
+    for (auto &project: projects)
+        portfolio.add(project);
+
+    cout << left << setw(28) << "method" << setw(16) << "ns/project" << setw(16) << "evaluations" << "speedup" << endl;
+    double perProject = timePerEval(projects.size(), [&] {
+        double sum = 0;
+        for (auto &project: projects)
+            sum += project.getIrr();
+        return sum;
+    });
+    cout << setw(28) << "Project::getIrr" << fixed << setprecision(2) << setw(16) << perProject << setw(16) << "-"
+         << "1.00x" << endl;
+
+    ThreadPool pool;
+    vector<IrrResult> results(projects.size());
+    struct {
+        const char *name;
+        ThreadPool *pool;
+    } runs[] = {{"Portfolio::irr, 1 thread", nullptr}, {"Portfolio::irr, pool", &pool}};
+    for (auto &run: runs) {
+        double ns = timePerEval(projects.size(), [&] {
+            portfolio.irr(results.data(), run.pool);
+            return results[0].rate;
+        });
+        double evaluations = 0;
+        for (auto &result: results)
+            evaluations += result.evaluations;
+        cout << setw(28) << run.name << setw(16) << ns << setw(16) << evaluations / results.size() << perProject / ns
+             << "x" << endl;
+    }
+
+    // getIrr is plain Newton in float and stops once a step is under 0.01 points
+    int converged = 0, off = 0;
+    double worst = 0;
+    for (size_t p = 0; p < projects.size(); ++p) {
+        converged += results[p].status == IrrStatus::Converged;
+        double difference = abs(projects[p].getIrr() - results[p].rate);
+        off += difference > 0.01;
+        worst = max(worst, difference);
+    }
+    cout << "converged: " << converged << "/" << projects.size() << ", getIrr off by more than 0.01 points: " << off
+         << ", largest difference " << worst << " points" << endl;
+}
+
+/**
+ * @brief Monte Carlo NPV risk of one candidate block: scenarios per second on 1 and all threads.
+ */
+void reportRisk() {
+    auto project = syntheticProjects(1)[0];
+    long long scenarios = 1000000;
+
+    cout << left << setw(12) << "threads" << setw(14) << "scenarios" << setw(12) << "seconds" << setw(16)
+         << "scenarios/s" << setw(10) << "P10" << setw(10) << "P50" << setw(10) << "P90" << endl;
+    vector<unsigned> threadCounts = {1};
+    if (thread::hardware_concurrency() > 1)
+        threadCounts.push_back(thread::hardware_concurrency());
+    for (unsigned threads: threadCounts) {
+        ThreadPool pool(threads);
+        auto start = chrono::steady_clock::now();
+        RiskResult risk = simulateNpv(project, RiskModel(), scenarios, &pool);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << setw(12) << threads << setw(14) << risk.scenarios << fixed << setprecision(3) << setw(12) << seconds
+             << setprecision(0) << setw(16) << scenarios / seconds << setprecision(2) << setw(10) << risk.p10
+             << setw(10) << risk.p50 << setw(10) << risk.p90 << endl;
+    }
+}
+
+/**
+ * @brief The NPV formula of Project::getNpv, in Dual numbers. Inputs are numbered revenue,
+ * operating cost and capital cost entries first, then the tax rate, then the discount rate.
+ */
+Dual dualNpv(const ProjectCashFlows &flows, double rate) {
+    size_t n = flows.year.size(), count = 3 * n + 2;
+    Dual tax = Dual::variable(flows.taxRate, 3 * n, count);
+    Dual base = 1 + Dual::variable(rate, 3 * n + 1, count) / 100;
+    Dual keep = 1 - tax / 100;
+
+    Dual npv;
+    for (size_t i = 0; i < n; ++i) {
+        Dual cf = (Dual::variable(flows.revenue[i], i, count) - Dual::variable(flows.operatingCost[i], n + i, count)) *
+                  keep - Dual::variable(flows.capitalCost[i], 2 * n + i, count);
+        npv += cf * pow(base, -flows.year[i]);
+    }
+
+    return npv;
+}
+
+/**
+ * @brief Sensitivity::gradient by forward-mode AD instead of the closed forms, O(n^2), as a
+ * reference for the self-test and the benchmark.
+ */
+ProjectGradient dualGradient(const ProjectCashFlows &flows) {
+    size_t n = flows.year.size();
+    ProjectGradient g;
+
+    Dual value = dualNpv(flows, flows.discountRate);
+    g.npv = value.getValue();
+    for (size_t i = 0; i < n; ++i) {
+        g.npvRevenue.push_back(value.derivative(i));
+        g.npvOperatingCost.push_back(value.derivative(n + i));
+        g.npvCapitalCost.push_back(value.derivative(2 * n + i));
+    }
+    g.npvTaxRate = value.derivative(3 * n);
+    g.npvDiscountRate = value.derivative(3 * n + 1);
+
+    vector<double> cashFlow(n);
+    for (size_t i = 0; i < n; ++i)
+        cashFlow[i] = (flows.revenue[i] - flows.operatingCost[i]) * (1 - flows.taxRate / 100) - flows.capitalCost[i];
+    IrrResult rate = irr(flows.year, cashFlow);
+    g.irr = rate.rate;
+    g.irrStatus = rate.status;
+    if (rate.status != IrrStatus::Converged)
+        return g;
+
+    Dual atIrr = dualNpv(flows, rate.rate);
+    double slope = atIrr.derivative(3 * n + 1);
+    for (size_t i = 0; i < n; ++i) {
+        g.irrRevenue.push_back(-atIrr.derivative(i) / slope);
+        g.irrOperatingCost.push_back(-atIrr.derivative(n + i) / slope);
+        g.irrCapitalCost.push_back(-atIrr.derivative(2 * n + i) / slope);
+    }
+    g.irrTaxRate = -atIrr.derivative(3 * n) / slope;
+
+    return g;
+}
+
+/**
+ * @brief Tornado chart and gradient of one candidate block: rebuilding a Project per perturbation
+ * against the incremental Sensitivity updates, and the closed-form gradient against Dual numbers.
+ */
+void reportSensitivity() {
+    auto project = syntheticProjects(1)[0];
+    double change = 0.1;
+
+    // the old way: a new Project for every perturbed input
+    auto rebuilt = [&] {
+        double sum = 0;
+        for (double factor: {1 - change, 1 + change}) {
+            auto scaled = [&](const vector<double> &v) {
+                vector<double> out(v);
+                for (double &x: out)
+                    x *= factor;
+                return out;
+            };
+            auto &y = project.getYear();
+            auto &op = project.getOperatingCost();
+            auto &capex = project.getCapitalCost();
+            auto &rev = project.getRevenue();
+            double tax = project.getTaxRate(), rate = project.getDiscountRate();
+            sum += Project<double>("", y, op, capex, scaled(rev), tax, rate).getNpv();
+            sum += Project<double>("", y, scaled(op), capex, rev, tax, rate).getNpv();
+            sum += Project<double>("", y, op, scaled(capex), rev, tax, rate).getNpv();
+            sum += Project<double>("", y, op, capex, rev, tax * factor, rate).getNpv();
+            sum += Project<double>("", y, op, capex, rev, tax, rate * factor).getNpv();
+        }
+        return sum;
+    };
+    Sensitivity sensitivity(project);
+    auto incremental = [&] {
+        double sum = 0;
+        for (auto &bar: sensitivity.tornado(change))
+            sum += bar.low + bar.high;
+        return sum;
+    };
+
+    cout << left << setw(36) << "method" << "ns/call" << endl;
+    cout << setw(36) << "tornado, rebuilt Projects" << fixed << setprecision(1) << timePerEval(1, rebuilt) << endl;
+    cout << setw(36) << "tornado, Sensitivity" << timePerEval(1, incremental) << endl;
+    cout << setw(36) << "tornado, Sensitivity incl. setup" << timePerEval(1, [&] {
+        return Sensitivity(project).tornado(change)[0].low;
+    }) << endl;
+
+    // gradient: closed forms in O(n), against one-sided finite differences and the O(n^2) Dual passes
+    size_t n = project.getYear().size();
+    auto flows = cashFlowsOf(project);
+    auto finite = [&] {
+        double sum = 0, h = 1e-6;
+        for (auto *series: {&flows.revenue, &flows.operatingCost, &flows.capitalCost})
+            for (size_t i = 0; i < n; ++i) {
+                double saved = (*series)[i];
+                (*series)[i] += h;
+                sum += (Sensitivity(flows).getNpv() - sensitivity.getNpv()) / h;
+                (*series)[i] = saved;
+            }
+        return sum;
+    };
+    cout << setw(36) << "NPV gradient, finite differences" << timePerEval(1, finite) << endl;
+    cout << setw(36) << "NPV and IRR gradients, closed form" << timePerEval(1, [&] { return sensitivity.gradient().irr; })
+         << endl;
+    cout << setw(36) << "NPV and IRR gradients, Dual" << timePerEval(1, [&] { return dualGradient(flows).irr; }) << endl;
+
+    cout << endl << setw(18) << "input" << setw(12) << "-10%" << "+10%" << endl;
+    for (auto &bar: sensitivity.tornado(change))
+        cout << setw(18) << bar.name << setprecision(2) << setw(12) << bar.low << bar.high << endl;
+}
+
+/**
+ * @brief Writes projects in the CSV format of loadProjectsCsv, one row per project and year.
+ */
+void writeProjectsCsv(const string &path, const vector<Project<double>> &projects) {
+    ofstream csv(path);
+    csv << "name,year,operating_cost,capital_cost,revenue,tax_rate,discount_rate\n" << setprecision(17);
+    for (auto &project: projects)
+        for (size_t t = 0; t < project.getYear().size(); ++t)
+            csv << project.getName() << ',' << project.getYear()[t] << ',' << project.getOperatingCost()[t] << ','
+                << project.getCapitalCost()[t] << ',' << project.getRevenue()[t] << ',' << project.getTaxRate()
+                << ',' << project.getDiscountRate() << '\n';
+}
+
+/**
+ * @brief Loads 20k projects from CSV and from the columnar format: throughput in MB/s, against
+ * reading the same CSV with iostreams, and the cost of turning the table into a portfolio.
+ */
+void reportLoader() {
+    auto projects = syntheticProjects(20000);
+    auto directory = filesystem::temp_directory_path();
+    string csvPath = (directory / "numerical_modelling_projects.csv").string();
+    string columnarPath = (directory / "numerical_modelling_projects.bin").string();
+
+    writeProjectsCsv(csvPath, projects);
+
+    string error;
+    ProjectTable table;
+    if (!loadProjectsCsv(csvPath, table, &error) || !writeColumnar(columnarPath, table, &error)) {
+        cout << error << endl;
+        return;
+    }
+    double csvBytes = (double) filesystem::file_size(csvPath), columnarBytes = (double) filesystem::file_size(columnarPath);
+
+    // the baseline: getline and a stringstream per row, a new Project per name
+    auto iostreams = [&] {
+        ifstream in(csvPath);
+        string line, name, field;
+        vector<Project<double>> loaded;
+        vector<double> columns[4];
+        double tax = 0, rate = 0;
+        getline(in, line);
+        while (getline(in, line)) {
+            stringstream row(line);
+            string rowName;
+            getline(row, rowName, ',');
+            if (rowName != name && !columns[0].empty()) {
+                loaded.emplace_back(name, columns[0], columns[1], columns[2], columns[3], tax, rate);
+                for (auto &column: columns)
+                    column.clear();
+            }
+            name = rowName;
+            for (auto &column: columns) {
+                getline(row, field, ',');
+                column.push_back(stod(field));
+            }
+            getline(row, field, ',');
+            tax = stod(field);
+            getline(row, field, ',');
+            rate = stod(field);
+        }
+        loaded.emplace_back(name, columns[0], columns[1], columns[2], columns[3], tax, rate);
+        return (double) loaded.size();
+    };
+    // the mapping is lazy, so the columnar load is timed through a pass over every column
+    auto columnar = [&] {
+        ProjectTable mapped;
+        loadProjectsColumnar(columnarPath, mapped, nullptr);
+        double sum = 0;
+        for (size_t p = 0; p < mapped.size(); ++p)
+            for (auto column: {mapped.getYear(p), mapped.getOperatingCost(p), mapped.getCapitalCost(p),
+                               mapped.getRevenue(p)})
+                for (double x: column)
+                    sum += x;
+        return sum;
+    };
+
+    cout << left << setw(32) << "method" << setw(12) << "ms" << "MB/s" << endl;
+    struct {
+        const char *name;
+        double bytes;
+        function<double()> load;
+    } runs[] = {{"CSV, iostreams", csvBytes, iostreams},
+                {"CSV, mapped + from_chars", csvBytes, [&] {
+                    ProjectTable loaded;
+                    loadProjectsCsv(csvPath, loaded, nullptr);
+                    return (double) loaded.size();
+                }},
+                {"columnar, mapped", columnarBytes, columnar}};
+    for (auto &run: runs) {
+        double ns = timePerEval(1, run.load);
+        cout << setw(32) << run.name << fixed << setprecision(2) << setw(12) << ns * 1e-6 << run.bytes * 1e3 / ns
+             << endl;
+    }
+
+    ProjectTable mapped;
+    loadProjectsColumnar(columnarPath, mapped, nullptr);
+    double fromProjects = timePerEval(projects.size(), [&] {
+        Portfolio portfolio;
+        for (auto &project: projects)
+            portfolio.add(project);
+        return (double) portfolio.size();
+    });
+    double fromTable = timePerEval(projects.size(), [&] {
+        Portfolio portfolio;
+        mapped.addTo(portfolio);
+        return (double) portfolio.size();
+    });
+    cout << endl << setw(32) << "portfolio from" << "ns/project" << endl;
+    cout << setw(32) << "vector<Project>" << fromProjects << endl;
+    cout << setw(32) << "mapped columnar table" << fromTable << endl;
+    cout << "CSV " << scientific << setprecision(3) << csvBytes / 1e6 << " MB, columnar " << columnarBytes / 1e6
+         << " MB, " << mapped.size() << " projects" << endl;
+
+    filesystem::remove(csvPath);
+    filesystem::remove(columnarPath);
+}
+
+/**
+ * @brief The correctness checks behind --selftest, registered with CTest: every Adler-32 and
+ * CRC-32 kernel the build and CPU have against the reference ComputeAdler32 and UpdateCRC32,
+ * PNG and deflate round trips, pool tasks that wait for parallel work of their own, integrals
+ * and IRRs with known values, the closed-form Sensitivity gradients against Dual numbers and a
+ * CSV to columnar round trip of the loaders.
+ *
+ * @return the number of failed checks
+ */
+int selfTest() {
+    auto pbPlotsTest = [](void (*test)(NumberReference *)) {
+        NumberReference *failures = CreateNumberReference(0);
+        test(failures);
+        int count = (int) failures->numberValue;
+        delete failures;
+        return count;
+    };
+    int adler32 = pbPlotsTest(TestAdler32);
+    cout << "Adler-32 kernels (path " << Adler32SIMDPath() << " and below): " << adler32 << " failures" << endl;
+    int crc32 = pbPlotsTest(TestCRC32);
+    cout << "CRC-32 kernels (hardware " << (CRC32HardwareAvailable() ? "and " : "not available, ") << "slice-by-8): "
+         << crc32 << " failures" << endl;
+    int png = pbPlotsTest(TestPNGRoundTrip);
+    cout << "PNG and deflate round trips: " << png << " failures" << endl;
+
+    // a task that waits for its own parallelFor must not wait for itself; a deadlock here
+    // shows up as the CTest timeout
+    int nested = 0;
+    for (unsigned threads: {1u, 2u, 4u}) {
+        ThreadPool pool(threads);
+        atomic<int> count{0};
+        for (int t = 0; t < 4; ++t)
+            pool.submit([&] { pool.parallelFor(0, 8, 1, [&](size_t) { count++; }); });
+        pool.wait();
+        pool.parallelFor(0, 4, 1, [&](size_t) {
+            pool.parallelFor(0, 8, 1, [&](size_t) { count++; });
+        });
+        nested += count != 64;
+    }
+    cout << "nested parallelFor (1, 2 and 4 threads): " << nested << " failures" << endl;
+
+    // integrals with known values, each to well within its rule's accuracy
+    auto wrong = [](double value, double exact, double tolerance) { return !(abs(value - exact) <= tolerance); };
+    double e = exp(1.0);
+    auto cube = [](double x) { return x * x * x * x * x; };
+    auto product = [](const Point<2> &p) { return exp(p[0] + p[1]); };
+    auto product3 = [](const Point<3> &p) { return exp(p[0] + p[1] + p[2]); };
+    auto bilinear = [](const Point<2> &p) { return p[0] * p[1]; };
+    QuadratureResult sobol = monteCarlo<2>(bilinear, {0, 0}, {1, 1}, Sampler::Sobol, 1e-5, 1 << 20);
+    QuadratureResult pseudo = monteCarlo([](double x) { return x * x; }, 0, 1, Sampler::Pseudo, 1e-3, 1 << 20);
+    int integrals = wrong(simpsons(1000, [](double x) { return cos(x); }, 0, 1), sin(1.0), 1e-12) +
+                    wrong(adaptiveSimpson([](double x) { return sin(x); }, 0, M_PI, 1e-10).value, 2, 1e-9) +
+                    wrong(gaussKronrod15([](double x) { return exp(x); }, 0, 1, 1e-12).value, e - 1, 1e-12) +
+                    wrong(Romberg([](double x) { return 1 / (1 + x * x); }, 0, 1).integrate(1e-12).value, M_PI / 4,
+                          1e-10) +
+                    wrong(newtonCotes<BooleRule, 4>(cube, 0, 2), 64.0 / 6, 1e-12) +
+                    wrong(gaussLegendre<5>([](double x) { return pow(x, 8); }, -1, 1), 2.0 / 9, 1e-14) +
+                    wrong(tensorProduct<2>(32, simpsonsNodes, product, {0, 0}, {1, 1}).value, (e - 1) * (e - 1), 1e-7) +
+                    wrong(smolyak<3>(6, simpsonsNodes, product3, {0, 0, 0}, {1, 1, 1}).value, pow(e - 1, 3), 1e-6) +
+                    (!sobol.converged || wrong(sobol.value, 0.25, 6 * sobol.error)) +
+                    (!pseudo.converged || wrong(pseudo.value, 1.0 / 3, 6 * pseudo.error));
+    cout << "integrals with known values (quadrature, cubature, QMC): " << integrals << " failures" << endl;
+
+    // IRRs with known values: 10% for one and for two years, 21% when the return comes after half a year
+    struct KnownIrr {
+        vector<double> year, cashFlow;
+        double rate;
+    } knownIrrs[] = {{{0, 1}, {-100, 110}, 10}, {{0, 1, 2}, {-100, 0, 121}, 10}, {{0, 0.5}, {-100, 110}, 21},
+                     {{0, 1, 2, 3}, {-1000, 0, 0, 1331}, 10}};
+    int irrs = 0;
+    for (auto &known: knownIrrs) {
+        IrrResult result = irr(known.year, known.cashFlow);
+        irrs += result.status != IrrStatus::Converged || !result.unique || wrong(result.rate, known.rate, 1e-9);
+    }
+    irrs += irr(vector<double>{0, 1}, vector<double>{100, 10}).status != IrrStatus::NoRoot;
+    cout << "IRRs with known values: " << irrs << " failures" << endl;
+
+    // the closed-form gradients against the Dual-number oracle
+    int gradient = 0;
+    for (auto &project: syntheticProjects(20, 7)) {
+        auto flows = cashFlowsOf(project);
+        ProjectGradient closed = Sensitivity(flows).gradient(), dual = dualGradient(flows);
+        auto near = [](double x, double y) { return abs(x - y) <= 1e-9 * max(1.0, abs(y)); };
+        auto nearAll = [&](const vector<double> &x, const vector<double> &y) {
+            return x.size() == y.size() && equal(x.begin(), x.end(), y.begin(), near);
+        };
+        gradient += !near(closed.npv, dual.npv) || !nearAll(closed.npvRevenue, dual.npvRevenue) ||
+                    !nearAll(closed.npvOperatingCost, dual.npvOperatingCost) ||
+                    !nearAll(closed.npvCapitalCost, dual.npvCapitalCost) || !near(closed.npvTaxRate, dual.npvTaxRate) ||
+                    !near(closed.npvDiscountRate, dual.npvDiscountRate) || closed.irrStatus != dual.irrStatus ||
+                    !nearAll(closed.irrRevenue, dual.irrRevenue) ||
+                    !nearAll(closed.irrOperatingCost, dual.irrOperatingCost) ||
+                    !nearAll(closed.irrCapitalCost, dual.irrCapitalCost) || !near(closed.irrTaxRate, dual.irrTaxRate);
+    }
+    cout << "NPV and IRR gradients against Dual numbers (20 projects): " << gradient << " failures" << endl;
+
+    // CSV -> table -> columnar file -> mapped table gives back every field exactly
+    int loader = 0;
+    {
+        auto projects = syntheticProjects(50, 11);
+        auto directory = filesystem::temp_directory_path();
+        string csvPath = (directory / "numerical_modelling_selftest.csv").string();
+        string columnarPath = (directory / "numerical_modelling_selftest.bin").string();
+        writeProjectsCsv(csvPath, projects);
+
+        ProjectTable parsed, mapped;
+        string error;
+        if (!loadProjectsCsv(csvPath, parsed, &error) || !writeColumnar(columnarPath, parsed, &error) ||
+            !loadProjectsColumnar(columnarPath, mapped, &error)) {
+            cout << error << endl;
+            ++loader;
+        } else if (mapped.size() != projects.size()) {
+            ++loader;
+        } else {
+            auto same = [](span<const double> x, const vector<double> &y) { return ranges::equal(x, y); };
+            for (size_t p = 0; p < projects.size(); ++p)
+                loader += mapped.getName(p) != projects[p].getName() || !same(mapped.getYear(p), projects[p].getYear()) ||
+                          !same(mapped.getOperatingCost(p), projects[p].getOperatingCost()) ||
+                          !same(mapped.getCapitalCost(p), projects[p].getCapitalCost()) ||
+                          !same(mapped.getRevenue(p), projects[p].getRevenue()) ||
+                          mapped.getTaxRate(p) != projects[p].getTaxRate() ||
+                          mapped.getDiscountRate(p) != projects[p].getDiscountRate();
+        }
+        filesystem::remove(csvPath);
+        filesystem::remove(columnarPath);
+    }
+    cout << "CSV to columnar round trip (50 projects): " << loader << " failures" << endl;
+
+    return adler32 + crc32 + png + nested + integrals + irrs + gradient + loader;
+}
+
+/**
+ * @brief Prints the command line and, if given, what was wrong with it.
+ *
+ * @return the exit status for a bad command line
+ */
+int usage(const char *program, const string &problem = "") {
+    if (!problem.empty())
+        cerr << program << ": " << problem << endl;
+    cerr << "usage: " << program << " [--format=console|json|csv] [--out=<file>] [--filter=<regex>]"
+         << " [--min_time=<seconds>] [--selftest]" << endl;
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        auto value = [&](const string &flag) { return arg.rfind(flag + "=", 0) == 0 ? arg.substr(flag.size() + 1) : ""; };
+
+        if (arg == "--selftest")
+            options.selfTest = true;
+        else if (!value("--format").empty())
+            options.format = value("--format");
+        else if (!value("--out").empty())
+            options.out = value("--out");
+        else if (!value("--filter").empty())
+            options.filter = value("--filter");
+        else if (!value("--min_time").empty()) {
+            string text = value("--min_time");
+            auto [end, ec] = from_chars(text.data(), text.data() + text.size(), options.minTime);
+            if (ec != errc() || end != text.data() + text.size() || !(options.minTime > 0) || isinf(options.minTime))
+                return usage(argv[0], "--min_time takes a positive number of seconds, not " + text);
+        } else
+            return usage(argv[0], arg == "--help" ? "" : "unknown option " + arg);
+    }
+    if (options.selfTest)
+        return selfTest() == 0 ? 0 : 1;
+    if (options.format != "console" && options.format != "json" && options.format != "csv")
+        return usage(argv[0], "unknown format " + options.format);
+    minTime = options.minTime;
+
+    regex filter;
+    try {
+        filter = regex(options.filter);
+    } catch (const regex_error &error) {
+        return usage(argv[0], "invalid --filter " + options.filter + ": " + error.what());
+    }
+
+    // opened before the suite runs, so a bad path fails at once rather than after the timings
+    ofstream file;
+    if (!options.out.empty()) {
+        file.open(options.out);
+        if (!file)
+            return usage(argv[0], "cannot open " + options.out + " for writing");
+    }
+
+    // cost classes: F2 is a cheap polynomial, F1 four exponentials per point
+    vector<BenchRecord> records;
+    suiteFor(F2(), "F2", "cheap", exp(1), 5, filter, records);
+    suiteFor(F1(), "F1", "expensive", 1, 2, filter, records);
+
+    ostream &out = options.out.empty() ? cout : file;
+
+    if (options.format == "json")
+        writeJson(out, records);
+    else if (options.format == "csv")
+        writeCsv(out, records);
+    else
+        writeConsole(out, records);
+    if (!options.out.empty()) {
+        file.close();
+        if (!file) {
+            cerr << argv[0] << ": cannot write " << options.out << endl;
+            return 1;
+        }
+    }
+
+    // the reports are for reading, they only run with the console format
+    if (options.format != "console")
+        return 0;
+
+    struct Report {
+        const char *name;
+        void (*run)();
+    } reports[] = {{"report/call_overhead", reportCallOverhead}, {"report/fixed_order", reportFixedOrder},
+                   {"report/cubature", reportCubature}, {"report/monte_carlo", reportMonteCarlo},
+                   {"report/sweep", reportSweep}, {"report/portfolio", reportPortfolio},
+                   {"report/irr", reportIrr}, {"report/risk", reportRisk},
+                   {"report/sensitivity", reportSensitivity}, {"report/loader", reportLoader}};
+    for (auto &report: reports)
+        if (regex_search(report.name, filter)) {
+            cout << endl << report.name << endl;
+            report.run();
+        }
+
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "quadrature.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * A point in D dimensions.
+ */
+template<std::size_t D>
+using Point = std::array<double, D>;
+
+/**
+ * Anything that can be called with a Point<D> and returns something convertible to double.
+ */
+template<typename F, std::size_t D>
+concept CubatureIntegrand = std::invocable<F &, const Point<D> &> &&
+                            std::convertible_to<std::invoke_result_t<F &, const Point<D> &>, double>;
+
+/**
+ * A cubature integrand that can also fill y[k] = f(x[0][k], ..., x[D-1][k]) for a block of points,
+ * with the coordinates passed one array per dimension.
+ */
+template<typename F, std::size_t D>
+concept BatchCubatureIntegrand = CubatureIntegrand<F, D> &&
+                                 requires(const F &f, const double *const *x, double *y, std::size_t n) {
+                                     f.eval(x, y, n);
+                                 };
+
+/**
+ * Nodes and weights of a 1D rule on one interval: the integral is approximated by sum w[i] f(x[i]).
+ */
+struct QuadratureNodes {
+    std::vector<double> x, w;
+};
+
+/**
+ * Integral and number of integrand evaluations of a cubature.
+ */
+struct CubatureResult {
+    double value = 0;
+    long long evaluations = 0;
+};
+
+/**
+ * @brief Nodes and weights of the composite trapezoidal rule, h/2 (1, 2, ..., 2, 1).
+ *
+ * @param n - number of intervals
+ * @param a - the lower bound of the interval
+ * @param b - the upper bound of the interval
+ */
+inline QuadratureNodes trapezoidalNodes(int n, double a, double b) {
+    double h = (b - a) / n;
+    QuadratureNodes rule;
+
+    for (int i = 0; i <= n; ++i) {
+        rule.x.push_back(a + i * h);
+        rule.w.push_back(i == 0 || i == n ? h / 2 : h);
+    }
+
+    return rule;
+}
+
+/**
+ * @brief Nodes and weights of the composite Simpson's ⅓ rule, h/3 (1, 4, 2, ..., 2, 4, 1).
+ *
+ * @param n - number of intervals, must be even
+ * @param a - the lower bound of the interval
+ * @param b - the upper bound of the interval
+ */
+inline QuadratureNodes simpsonsNodes(int n, double a, double b) {
+    double h = (b - a) / n;
+    QuadratureNodes rule;
+
+    for (int i = 0; i <= n; ++i) {
+        rule.x.push_back(a + i * h);
+        rule.w.push_back((i == 0 || i == n ? 1 : i % 2 ? 4 : 2) * h / 3);
+    }
+
+    return rule;
+}
+
+/**
+ * @brief Evaluates f on n points given as one coordinate array per dimension.
+ */
+template<std::size_t D, typename F>
+void evalCubaturePoints(F &f, const double *const *x, double *y, std::size_t n) {
+    if constexpr (BatchCubatureIntegrand<std::remove_cvref_t<F>, D>) {
+        f.eval(x, y, n);
+    } else {
+        for (std::size_t k = 0; k < n; ++k) {
+            Point<D> p;
+            for (std::size_t d = 0; d < D; ++d)
+                p[d] = x[d][k];
+            y[k] = f(p);
+        }
+    }
+}
+
+/**
+ * @brief Integrates f over a box with the tensor product of one 1D rule per dimension.
+ *
+ * The grid is walked one slab of the outermost dimension at a time. Inside a slab the points
+ * are generated QUADRATURE_BATCH_SIZE at a time, innermost dimension fastest, into coordinate
+ * and weight arrays that stay in L1, evaluated as a block and reduced with a single dot product.
+ * With a pool the slabs run in parallel; the slab sums are still added in order, so the result
+ * does not depend on the number of threads.
+ *
+ * @param rules - the 1D rule of each dimension
+ * @param f - the function to integrate
+ * @param pool - the pool to spread the slabs over, or nullptr to run on the calling thread
+ * @return the integral and the number of evaluations
+ */
+template<std::size_t D, typename F> requires CubatureIntegrand<F, D>
+CubatureResult tensorProduct(const std::array<QuadratureNodes, D> &rules, const F &f, ThreadPool *pool = nullptr) {
+    static_assert(D >= 1, "at least one dimension");
+
+    std::size_t slabs = rules[0].x.size();
+    std::size_t inner = 1;
+    for (std::size_t d = 1; d < D; ++d)
+        inner *= rules[d].x.size();
+
+    std::vector<double> partial(slabs);
+    auto slab = [&](std::size_t i0) {
+        double coords[D][QUADRATURE_BATCH_SIZE];
+        const double *x[D];
+        double w[QUADRATURE_BATCH_SIZE], y[QUADRATURE_BATCH_SIZE];
+        std::size_t index[D] = {};
+
+        for (std::size_t d = 0; d < D; ++d)
+            x[d] = coords[d];
+
+        double sum = 0;
+        for (std::size_t first = 0; first < inner; first += QUADRATURE_BATCH_SIZE) {
+            std::size_t m = std::min<std::size_t>(QUADRATURE_BATCH_SIZE, inner - first);
+
+            for (std::size_t k = 0; k < m; ++k) {
+                double weight = 1;
+                coords[0][k] = rules[0].x[i0];
+                for (std::size_t d = 1; d < D; ++d) {
+                    coords[d][k] = rules[d].x[index[d]];
+                    weight *= rules[d].w[index[d]];
+                }
+                w[k] = weight;
+
+                // odometer over the inner dimensions, last one fastest
+                for (std::size_t d = D - 1; d >= 1 && ++index[d] == rules[d].x.size(); --d)
+                    index[d] = 0;
+            }
+
+            evalCubaturePoints<D>(f, x, y, m);
+#pragma omp simd reduction(+:sum)
+            for (std::size_t k = 0; k < m; ++k)
+                sum += w[k] * y[k];
+        }
+
+        partial[i0] = sum;
+    };
+
+    if (pool)
+        pool->parallelFor(0, slabs, 1, slab);
+    else
+        for (std::size_t i0 = 0; i0 < slabs; ++i0)
+            slab(i0);
+
+    CubatureResult result;
+    for (std::size_t i0 = 0; i0 < slabs; ++i0)
+        result.value += rules[0].w[i0] * partial[i0];
+    result.evaluations = (long long) slabs * inner;
+
+    return result;
+}
+
+/**
+ * @brief Tensor-product cubature with the same composite rule and n in every dimension.
+ *
+ * @param n - number of intervals per dimension
+ * @param rule - trapezoidalNodes or simpsonsNodes
+ * @param f - the function to integrate
+ * @param a - the lower corner of the box
+ * @param b - the upper corner of the box
+ * @param pool - the pool to spread the slabs over, or nullptr to run on the calling thread
+ * @return the integral and the number of evaluations
+ */
+template<std::size_t D, typename F> requires CubatureIntegrand<F, D>
+CubatureResult tensorProduct(int n, QuadratureNodes (*rule)(int, double, double), const F &f,
+                             const Point<D> &a, const Point<D> &b, ThreadPool *pool = nullptr) {
+    std::array<QuadratureNodes, D> rules;
+    for (std::size_t d = 0; d < D; ++d)
+        rules[d] = rule(n, a[d], b[d]);
+
+    return tensorProduct<D>(rules, f, pool);
+}
+
+/**
+ * @brief Smolyak sparse-grid cubature by the combination technique.
+ *
+ * The 1D rule at level l uses 2^l intervals. With q = level + D - 1 the sparse grid is
+ *
+ *   A(q, D) = sum over q - D + 1 <= |l| <= q of (-1)^(q - |l|) C(D - 1, q - |l|) (U^l1 x ... x U^lD)
+ *
+ * so only anisotropic grids whose levels add up to about q are evaluated instead of the full
+ * 2^level per dimension. For smooth integrands the error is close to that of the full grid at
+ * a fraction of the points; each component grid runs through tensorProduct.
+ *
+ * @param level - refinement level, 1 is the coarsest
+ * @param rule - trapezoidalNodes or simpsonsNodes
+ * @param f - the function to integrate
+ * @param a - the lower corner of the box
+ * @param b - the upper corner of the box
+ * @param pool - the pool to spread the slabs over, or nullptr to run on the calling thread
+ * @return the integral and the number of evaluations over all component grids
+ */
+template<std::size_t D, typename F> requires CubatureIntegrand<F, D>
+CubatureResult smolyak(int level, QuadratureNodes (*rule)(int, double, double), const F &f,
+                       const Point<D> &a, const Point<D> &b, ThreadPool *pool = nullptr) {
+    int q = level + (int) D - 1;
+
+    // cache the 1D rules, every component grid draws from the same levels
+    std::vector<std::array<QuadratureNodes, D>> levels(level + 1);
+    for (int l = 1; l <= level; ++l)
+        for (std::size_t d = 0; d < D; ++d)
+            levels[l][d] = rule(1 << l, a[d], b[d]);
+
+    CubatureResult result;
+    std::array<int, D> l;
+
+    auto visit = [&](auto &self, std::size_t d, int used) -> void {
+        if (d == D - 1) {
+            // the last level makes |l| land in [q - D + 1, q]
+            for (int last = std::max(1, q - (int) D + 1 - used); last <= q - used && last <= level; ++last) {
+                l[d] = last;
+                int k = q - (used + last);
+
+                double coefficient = k % 2 ? -1 : 1;
+                for (int i = 1; i <= k; ++i)
+                    coefficient = coefficient * ((int) D - i) / i;
+
+                std::array<QuadratureNodes, D> rules;
+                for (std::size_t i = 0; i < D; ++i)
+                    rules[i] = levels[l[i]][i];
+
+                CubatureResult grid = tensorProduct<D>(rules, f, pool);
+                result.value += coefficient * grid.value;
+                result.evaluations += grid.evaluations;
+            }
+            return;
+        }
+
+        for (int next = 1; next <= level && used + next <= q - (int) (D - 1 - d); ++next) {
+            l[d] = next;
+            self(self, d + 1, used + next);
+        }
+    };
+    visit(visit, 0, 0);
+
+    return result;
+}
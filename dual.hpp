@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Forward-mode automatic differentiation number carrying the whole gradient.
+ *
+ * Each value holds its derivatives with respect to every input at once, so one evaluation of a
+ * formula written in Dual gives the value and the full gradient together. An empty gradient
+ * stands for a constant and costs nothing to propagate. Every operation costs O(inputs), so it
+ * serves as a check on hand-derived gradients rather than as a fast way to compute them.
+ */
+class Dual {
+public:
+    Dual(double value = 0) : value(value) {}
+
+    /**
+     * @brief Input number `index` of `count`: its derivative with respect to itself is 1.
+     */
+    static Dual variable(double value, std::size_t index, std::size_t count) {
+        Dual x(value);
+        x.gradient.assign(count, 0.0);
+        x.gradient[index] = 1;
+        return x;
+    }
+
+    double getValue() const {
+        return value;
+    }
+
+    /**
+     * @return d(this)/d(input i), 0 for a constant
+     */
+    double derivative(std::size_t i) const {
+        return i < gradient.size() ? gradient[i] : 0;
+    }
+
+    friend Dual operator+(const Dual &x, const Dual &y) {
+        return combine(x.value + y.value, x, 1, y, 1);
+    }
+
+    friend Dual operator-(const Dual &x, const Dual &y) {
+        return combine(x.value - y.value, x, 1, y, -1);
+    }
+
+    friend Dual operator*(const Dual &x, const Dual &y) {
+        return combine(x.value * y.value, x, y.value, y, x.value);
+    }
+
+    friend Dual operator/(const Dual &x, const Dual &y) {
+        return combine(x.value / y.value, x, 1 / y.value, y, -x.value / (y.value * y.value));
+    }
+
+    Dual &operator+=(const Dual &y) {
+        return *this = *this + y;
+    }
+
+    /**
+     * @brief x^p for a constant exponent.
+     *
+     * The derivative is p x^(p-1), taken as 0 for p = 0, so at x = 0 it follows std::pow to 0
+     * or ±inf instead of dividing by x and giving 0/0 = NaN.
+     */
+    friend Dual pow(const Dual &x, double p) {
+        double slope = p == 0 ? 0 : p * std::pow(x.value, p - 1);
+        return combine(std::pow(x.value, p), x, slope, Dual(), 0);
+    }
+
+private:
+    /**
+     * @brief A result with the given value and gradient a dx + b dy.
+     */
+    static Dual combine(double value, const Dual &x, double a, const Dual &y, double b) {
+        Dual z(value);
+        z.gradient.resize(std::max(x.gradient.size(), y.gradient.size()), 0.0);
+        for (std::size_t i = 0; i < x.gradient.size(); ++i)
+            z.gradient[i] += a * x.gradient[i];
+        for (std::size_t i = 0; i < y.gradient.size(); ++i)
+            z.gradient[i] += b * y.gradient[i];
+        return z;
+    }
+
+    double value;
+    std::vector<double> gradient;
+};
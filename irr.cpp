@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "irr.hpp"
+
+using namespace std;
+
+CashFlowPolynomial::CashFlowPolynomial(const vector<double> &year, const vector<double> &cashFlow)
+        : year(year), cashFlow(cashFlow) {
+    integral = all_of(year.begin(), year.end(), [](double t) { return t >= 0 && t <= 1000 && t == floor(t); });
+    if (!integral)
+        return;
+
+    for (size_t i = 0; i < year.size(); ++i) {
+        size_t k = year[i];
+        if (coefficients.size() <= k)
+            coefficients.resize(k + 1, 0.0);
+        coefficients[k] += cashFlow[i];
+    }
+}
+
+pair<double, double> CashFlowPolynomial::npv(double r) const {
+    double v = 1 / (1 + r / 100);
+    double p = 0, dp = 0;
+
+    if (integral) {
+        for (size_t k = coefficients.size(); k-- > 0;) {
+            dp = dp * v + p;
+            p = p * v + coefficients[k];
+        }
+    } else {
+        for (size_t i = 0; i < year.size(); ++i) {
+            double term = cashFlow[i] * pow(v, year[i]);
+            p += term;
+            dp += year[i] * term / v;
+        }
+    }
+
+    // dv/dr = -v^2 / 100
+    return {p, -dp * v * v / 100};
+}
+
+int CashFlowPolynomial::signChanges() const {
+    vector<pair<double, double>> flows;
+    for (size_t i = 0; i < year.size(); ++i)
+        if (cashFlow[i] != 0)
+            flows.emplace_back(year[i], cashFlow[i]);
+    sort(flows.begin(), flows.end());
+
+    int changes = 0;
+    for (size_t i = 1; i < flows.size(); ++i)
+        if ((flows[i].second > 0) != (flows[i - 1].second > 0))
+            ++changes;
+    return changes;
+}
+
+/**
+ * @brief Brent's method on [a, b], where f(a) and f(b) have opposite signs, to a tolerance in r.
+ * Leaves the final bracket in a and b.
+ */
+static double brent(const CashFlowPolynomial &f, double &a, double &b, double fa, double fb, double tolerance,
+                    IrrResult &result) {
+    double c = a, fc = fa, d = b - a, e = d;
+
+    for (int iteration = 0; iteration < IRR_MAX_ITERATIONS; ++iteration) {
+        if ((fb > 0) == (fc > 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (abs(fc) < abs(fb)) {
+            a = b, b = c, c = a;
+            fa = fb, fb = fc, fc = fa;
+        }
+
+        double tol = 2 * numeric_limits<double>::epsilon() * abs(b) + tolerance / 2;
+        double m = (c - b) / 2;
+        if (abs(m) <= tol || fb == 0) {
+            a = c;
+            return b;
+        }
+
+        if (abs(e) >= tol && abs(fa) > abs(fb)) {
+            // inverse quadratic interpolation, or the secant step when only two points are distinct
+            double s = fb / fa, p, q;
+            if (a == c) {
+                p = 2 * m * s;
+                q = 1 - s;
+            } else {
+                double qa = fa / fc, r = fb / fc;
+                p = s * (2 * m * qa * (qa - r) - (b - a) * (r - 1));
+                q = (qa - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0)
+                q = -q;
+            else
+                p = -p;
+
+            if (2 * p < min(3 * m * q - abs(tol * q), abs(e * q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = d;
+            }
+        } else {
+            d = m;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += abs(d) > tol ? d : (m > 0 ? tol : -tol);
+        fb = f.npv(b).first;
+        ++result.evaluations;
+    }
+
+    a = c;
+    result.status = IrrStatus::NotConverged;
+    return b;
+}
+
+IrrResult irr(const vector<double> &year, const vector<double> &cashFlow, double tolerance) {
+    // rates to try, upwards from 0% first, then downwards towards -100%
+    static const vector<vector<double>> ladders = {
+            {0, 5, 10, 15, 20, 30, 50, 75, 100, 150, 200, 300, 500, 1000, 1e4, 1e5},
+            {0, -10, -25, -50, -75, -90, -99, -99.9}};
+
+    CashFlowPolynomial f(year, cashFlow);
+    IrrResult result;
+    result.unique = f.signChanges() <= 1;
+
+    double a = 0, fa = 0, b = 0, fb = 0;
+    bool bracketed = false;
+    for (auto &ladder: ladders) {
+        a = ladder[0];
+        fa = f.npv(a).first;
+        ++result.evaluations;
+        for (size_t i = 1; i < ladder.size() && !bracketed; ++i) {
+            b = ladder[i];
+            fb = f.npv(b).first;
+            ++result.evaluations;
+            if ((fa > 0) != (fb > 0) || fb == 0)
+                bracketed = true;
+            else
+                a = b, fa = fb;
+        }
+        if (bracketed || fa == 0)
+            break;
+    }
+
+    if (fa == 0 || fb == 0) {
+        result.rate = fa == 0 ? a : b;
+        result.status = IrrStatus::Converged;
+        return result;
+    }
+    if (!bracketed)
+        return result;
+
+    // Brent to a loose tolerance, then Newton to the requested one
+    result.status = IrrStatus::Converged;
+    double r = brent(f, a, b, fa, fb, max(tolerance, 1e-6), result);
+    bool polished = tolerance >= 1e-6 || result.status == IrrStatus::NotConverged;
+    double lo = min(a, b), hi = max(a, b);
+    for (int iteration = 0; iteration < 4 && !polished; ++iteration) {
+        auto [value, slope] = f.npv(r);
+        ++result.evaluations;
+        if (value == 0) {
+            polished = true;
+            break;
+        }
+        if (slope == 0)
+            break;
+
+        double next = r - value / slope;
+        if (next <= lo || next >= hi)
+            break;
+        polished = abs(next - r) <= tolerance;
+        r = next;
+    }
+
+    // Newton stalled, left the bracket or ran out of steps: finish with Brent at the requested tolerance
+    if (!polished) {
+        a = lo, b = hi;
+        fa = f.npv(a).first;
+        fb = f.npv(b).first;
+        result.evaluations += 2;
+        r = brent(f, a, b, fa, fb, tolerance, result);
+    }
+
+    result.rate = r;
+    return result;
+}
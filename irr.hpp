@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "project.hpp"
+
+#define IRR_MAX_ITERATIONS 100
+
+/**
+ * How an IRR search ended.
+ *
+ * Converged:    the rate is a root of the NPV to the requested tolerance.
+ * NoRoot:       the NPV has the same sign at every rate from -99.9% to 100000%.
+ * NotConverged: IRR_MAX_ITERATIONS were used up; the rate is the best estimate inside the bracket.
+ */
+enum class IrrStatus {
+    Converged,
+    NoRoot,
+    NotConverged
+};
+
+/**
+ * Outcome of an IRR search: the rate in percent, how many NPV evaluations it took, whether it
+ * converged and whether the cash flows change sign only once, which makes the IRR unique.
+ */
+struct IrrResult {
+    double rate = 0;
+    int evaluations = 0;
+    IrrStatus status = IrrStatus::NoRoot;
+    bool unique = true;
+};
+
+/**
+ * The NPV of a cash flow stream as a polynomial in the discount factor v = 1 / (1 + r / 100).
+ *
+ * When every year is a whole number the cash flows are summed into one coefficient per year and
+ * the NPV and its derivative come out of a single Horner pass with no pow at all. Fractional
+ * years fall back to one pow per cash flow, still in a single pass.
+ */
+class CashFlowPolynomial {
+public:
+    CashFlowPolynomial(const std::vector<double> &year, const std::vector<double> &cashFlow);
+
+    /**
+     * @brief NPV at a discount rate and its derivative with respect to the rate.
+     *
+     * @param r - the discount rate in percent
+     * @return NPV(r) and dNPV/dr
+     */
+    std::pair<double, double> npv(double r) const;
+
+    /**
+     * @return the number of sign changes in the cash flows, by Descartes' rule the most IRRs there can be
+     */
+    int signChanges() const;
+
+private:
+    bool integral;
+    std::vector<double> coefficients;
+    std::vector<double> year, cashFlow;
+};
+
+/**
+ * @brief Internal rate of return of a cash flow stream.
+ *
+ * The root is bracketed by scanning a fixed ladder of rates, upwards from 0% first, then
+ * located with Brent's method and polished with Newton steps. If the Newton steps leave the
+ * bracket or do not shrink below the tolerance, Brent's method finishes the search at the
+ * requested tolerance instead.
+ *
+ * @param year - the year of each cash flow
+ * @param cashFlow - the cash flows
+ * @param tolerance - the accuracy of the rate, in percentage points
+ * @return the rate in percent and how the search went
+ */
+IrrResult irr(const std::vector<double> &year, const std::vector<double> &cashFlow, double tolerance = 1e-10);
+
+/**
+ * @brief Internal rate of return of a project, from its after-tax cash flows.
+ */
+template<typename T>
+IrrResult irr(const Project<T> &project, double tolerance = 1e-10) {
+    std::vector<double> year(project.getYear().begin(), project.getYear().end()), cashFlow;
+    for (std::size_t i = 0; i < year.size(); ++i)
+        cashFlow.push_back((project.getRevenue()[i] - project.getOperatingCost()[i]) * (1 - project.getTaxRate() / 100) -
+                           project.getCapitalCost()[i]);
+
+    return irr(year, cashFlow, tolerance);
+}
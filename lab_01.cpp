@@ -1,76 +1,14 @@
+#include <fstream>
 #include <iomanip>
+#include "lab_01.hpp"
+#include "quadrature.hpp"
+#include "adaptive_quadrature.hpp"
+#include "romberg.hpp"
 #include "pbPlot/pbPlots.hpp"
 #include "pbPlot/supportLib.hpp"
 
 using namespace std;
 
-/**
- * Problem 1: f(x) = 4e^4x + 3e^3x + 2e^2x + e^x, x in [1,2]
- */
-class F1 {
-public:
-    constexpr static double TV = 3361.582962;
-
-    static double eval(double x) {
-        return (4 * exp(4 * x)) + (3 * exp(3 * x)) + (2 * exp(2 * x)) + exp(x);
-    }
-};
-
-/**
- * Problem 2: f(x) = x^3 + 2x + 1/x, x in [e,5]
- */
-class F2 {
-public:
-    constexpr static double TV = 160.8208443;
-
-    static double eval(double x) {
-        return pow(x, 3) + 2 * x + 1 / x;
-    }
-};
-
-/**
- * @brief Calculates the integral of f(x) from a to b using the trapezoidal rule.
- *
- * @param n - number of intervals
- * @param a - the lower bound of the integral
- * @param b - the upper bound of the integral
- * @param f - the function to integrate
- * @return the area under the curve
- */
-double trapezoidal(int n, double (*f)(double), double a, double b) {
-    double h = (b - a) / n;
-
-    double Tn = f(a) + f(b);        // first and last term
-    for (int i = 1; i < n; ++i)      // middle terms
-        Tn += 2 * f(a + i * h);
-    Tn *= h / 2;
-
-    return Tn;
-}
-
-/**
- * @brief Calculates the integral of f(x) from a to b using the Simpson's ⅓ rule.
- *
- * @param n - number of intervals
- * @param a - the lower bound of the integral
- * @param b - the upper bound of the integral
- * @param f - the function to integrate
- * @return the area under the curve
- */
-double simpsons(int n, double (*f)(double), double a, double b) {
-    double h = (b - a) / n;
-
-    double Tn = f(a) + f(b);        // first and last term
-    for (int i = 1; i < n; ++i)
-        if (i % 2)
-            Tn += 4 * f(a + i * h);     // odd terms
-        else
-            Tn += 2 * f(a + i * h);     // even terms
-    Tn *= h / 3;
-
-    return Tn;
-}
-
 /**
  * @brief Use pbPlot library to plot the percent error vs. n for the given function.
  *
@@ -118,8 +56,21 @@ bool plot(vector<double> &xs, vector<double> &ys, int fn, const string &rule) {
     if (success) {
         DrawImageOnImage(container, imageReference->image, 40, 0);
 
-        vector<double> *pngData = ConvertToPNG(container);
-        WriteToFile(pngData, rule + "_f" + to_string(fn) + ".png");
+        string path = rule + "_f" + to_string(fn) + ".png";
+        ofstream png(path, ios::binary);
+        errorMessage->string = toVector(L"");
+        success = png && ConvertToPNGStream(container, &png, 6, false, 0, 0.001, PNG_FILTER_ADAPTIVE, errorMessage);
+        png.close();
+        if (!success || png.fail()) {
+            success = false;
+            cerr << "Error: cannot write " << path;
+            if (!errorMessage->string->empty()) {
+                cerr << ": ";
+                for (wchar_t c: *errorMessage->string)
+                    wcerr << c;
+            }
+            cerr << endl;
+        }
         DeleteImage(imageReference->image);
     } else {
         cerr << "Error: ";
@@ -128,6 +79,8 @@ bool plot(vector<double> &xs, vector<double> &ys, int fn, const string &rule) {
         cerr << endl;
     }
 
+    DeleteImage(container);
+
     return success;
 }
 
@@ -136,54 +89,93 @@ int lab_01() {
 
     vector<double> xs, ytf1, ysf1, xt, ytf2, ysf2;
 
+    // Every trapezoidal sum from n/2 up is computed once: the Simpson sums follow from them as
+    // S(2m) = (4 T(2m) - T(m)) / 3, and the printout below reuses them instead of recomputing.
+    vector<double> tf1(n + 1), tf2(n + 1);
+    for (int i = 5; i <= n; i += 1) {
+        tf1[i] = trapezoidal(i, F1(), 1, 2);
+        tf2[i] = trapezoidal(i, F2(), exp(1), 5);
+    }
+    auto sf1 = [&](int i) { return (4 * tf1[i] - tf1[i / 2]) / 3; };
+    auto sf2 = [&](int i) { return (4 * tf2[i] - tf2[i / 2]) / 3; };
+
     for (int i = 10; i < n; i += 1) {
         double err;
 
         xt.push_back(i);
 
-        err = abs(trapezoidal(i, F1::eval, 1, 2) - F1::TV) / F1::TV * 100;
+        err = abs(tf1[i] - F1::TV) / F1::TV * 100;
         ytf1.push_back(err);
 
-        err = abs(trapezoidal(i, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100;
+        err = abs(tf2[i] - F2::TV) / F2::TV * 100;
         ytf2.push_back(err);
 
 
         if (!(i % 2)) {
             xs.push_back(i);
 
-            err = abs(simpsons(i, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100;
+            err = abs(sf2(i) - F2::TV) / F2::TV * 100;
             ysf2.push_back(err);
 
-            err = abs(simpsons(i, F1::eval, 1, 2) - F1::TV) / F1::TV * 100;
+            err = abs(sf1(i) - F1::TV) / F1::TV * 100;
             ysf1.push_back(err);
         }
     }
 
 
     cout << "Trapezoidal Rule: Function 1" << endl;
-    cout << "T10=" << fixed << setprecision(4) << trapezoidal(10, F1::eval, 1, 2) << " E10=" << fixed << setprecision(4)
-         << abs(trapezoidal(10, F1::eval, 1, 2) - F1::TV) / F1::TV * 100 << endl;
-    cout << "T100=" << fixed << setprecision(4) << trapezoidal(100, F1::eval, 1, 2) << " E100=" << fixed
-         << setprecision(4) << abs(trapezoidal(100, F1::eval, 1, 2) - F1::TV) / F1::TV * 100 << endl;
+    cout << "T10=" << fixed << setprecision(4) << tf1[10] << " E10=" << fixed << setprecision(4)
+         << abs(tf1[10] - F1::TV) / F1::TV * 100 << endl;
+    cout << "T100=" << fixed << setprecision(4) << tf1[100] << " E100=" << fixed
+         << setprecision(4) << abs(tf1[100] - F1::TV) / F1::TV * 100 << endl;
 
 
     cout << endl << "Simpsons Rule: Function 1" << endl;
-    cout << "T10=" << fixed << setprecision(4) << simpsons(10, F1::eval, 1, 2) << " E10=" << fixed << setprecision(7)
-         << abs(simpsons(10, F1::eval, 1, 2) - F1::TV) / F1::TV * 100 << endl;
-    cout << "T100=" << fixed << setprecision(7) << simpsons(100, F1::eval, 1, 2) << " E100=" << fixed << setprecision(7)
-         << abs(simpsons(100, F1::eval, 1, 2) - F1::TV) / F1::TV * 100 << endl;
+    cout << "T10=" << fixed << setprecision(4) << sf1(10) << " E10=" << fixed << setprecision(7)
+         << abs(sf1(10) - F1::TV) / F1::TV * 100 << endl;
+    cout << "T100=" << fixed << setprecision(7) << sf1(100) << " E100=" << fixed << setprecision(7)
+         << abs(sf1(100) - F1::TV) / F1::TV * 100 << endl;
 
     cout << endl << "Trapezoidal Rule: Function 2" << endl;
-    cout << "T10=" << fixed << setprecision(4) << trapezoidal(10, F2::eval, exp(1), 5) << " E10=" << fixed
-         << setprecision(4) << abs(trapezoidal(10, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100 << endl;
-    cout << "T100=" << fixed << setprecision(4) << trapezoidal(100, F2::eval, exp(1), 5) << " E100=" << fixed
-         << setprecision(4) << abs(trapezoidal(100, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100 << endl;
+    cout << "T10=" << fixed << setprecision(4) << tf2[10] << " E10=" << fixed
+         << setprecision(4) << abs(tf2[10] - F2::TV) / F2::TV * 100 << endl;
+    cout << "T100=" << fixed << setprecision(4) << tf2[100] << " E100=" << fixed
+         << setprecision(4) << abs(tf2[100] - F2::TV) / F2::TV * 100 << endl;
 
     cout << endl << "Simpsons Rule: Function 2" << endl;
-    cout << "T10=" << fixed << setprecision(4) << simpsons(10, F2::eval, exp(1), 5) << " E10=" << fixed
-         << setprecision(9) << abs(simpsons(10, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100 << endl;
-    cout << "T100=" << fixed << setprecision(7) << simpsons(100, F2::eval, exp(1), 5) << " E100=" << fixed
-         << setprecision(9) << abs(simpsons(100, F2::eval, exp(1), 5) - F2::TV) / F2::TV * 100 << endl;
+    cout << "T10=" << fixed << setprecision(4) << sf2(10) << " E10=" << fixed
+         << setprecision(9) << abs(sf2(10) - F2::TV) / F2::TV * 100 << endl;
+    cout << "T100=" << fixed << setprecision(7) << sf2(100) << " E100=" << fixed
+         << setprecision(9) << abs(sf2(100) - F2::TV) / F2::TV * 100 << endl;
+
+
+    // Doubling sweep: each level only evaluates the new midpoints
+    auto rombergSweep = [](const string &name, auto romberg, double TV) {
+        cout << endl << "Romberg: " << name << endl;
+        for (int level = 0; level < 6; ++level) {
+            if (level > 0)
+                romberg.refine();
+            cout << "n=" << romberg.getIntervals() << " T=" << fixed << setprecision(7) << romberg.getTrapezoidal()
+                 << " R=" << romberg.getRomberg() << " E=" << setprecision(9)
+                 << abs(romberg.getRomberg() - TV) / TV * 100 << " evaluations=" << romberg.getEvaluations() << endl;
+        }
+    };
+
+    rombergSweep("Function 1", Romberg(F1(), 1, 2, 10), F1::TV);
+    rombergSweep("Function 2", Romberg(F2(), exp(1), 5, 10), F2::TV);
+
+    double tolerance = 1e-6;
+    auto report = [](const string &name, const QuadratureResult &result, double TV) {
+        cout << endl << name << endl;
+        cout << "I=" << fixed << setprecision(7) << result.value << " estimated error=" << scientific
+             << setprecision(2) << result.error << " evaluations=" << result.evaluations
+             << " E=" << fixed << setprecision(9) << abs(result.value - TV) / TV * 100 << endl;
+    };
+
+    report("Adaptive Simpson: Function 1", adaptiveSimpson(F1(), 1, 2, tolerance), F1::TV);
+    report("G7-K15: Function 1", gaussKronrod15(F1(), 1, 2, tolerance), F1::TV);
+    report("Adaptive Simpson: Function 2", adaptiveSimpson(F2(), exp(1), 5, tolerance), F2::TV);
+    report("G7-K15: Function 2", gaussKronrod15(F2(), exp(1), 5, tolerance), F2::TV);
 
 
     cout << endl << "Generating plots..." << endl;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include "simd_math.hpp"
+
+/**
+ * Problem 1: f(x) = 4e^4x + 3e^3x + 2e^2x + e^x, x in [1,2]
+ */
+class F1 {
+public:
+    constexpr static double TV = 3361.582962;
+
+    static double eval(double x) {
+        return (4 * exp(4 * x)) + (3 * exp(3 * x)) + (2 * exp(2 * x)) + exp(x);
+    }
+
+    /**
+     * Batched form: with e = e^x the sum is e(1 + e(2 + e(3 + 4e))), one exponential per point.
+     */
+    static void eval(const double *x, double *y, size_t n) {
+        expBatch(x, y, n);
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i)
+            y[i] = y[i] * (1 + y[i] * (2 + y[i] * (3 + 4 * y[i])));
+    }
+
+    double operator()(double x) const {
+        return eval(x);
+    }
+
+    /**
+     * Exact integral from a to b, from the antiderivative e^4x + e^3x + e^2x + e^x.
+     */
+    static double exact(double a, double b) {
+        auto F = [](long double x) { return expl(4 * x) + expl(3 * x) + expl(2 * x) + expl(x); };
+        return F(b) - F(a);
+    }
+};
+
+/**
+ * Problem 2: f(x) = x^3 + 2x + 1/x, x in [e,5]
+ */
+class F2 {
+public:
+    constexpr static double TV = 160.8208443;
+
+    static double eval(double x) {
+        return x * x * x + 2 * x + 1 / x;
+    }
+
+    static void eval(const double *x, double *y, size_t n) {
+#pragma omp simd
+        for (size_t i = 0; i < n; ++i)
+            y[i] = x[i] * x[i] * x[i] + 2 * x[i] + 1 / x[i];
+    }
+
+    double operator()(double x) const {
+        return eval(x);
+    }
+
+    /**
+     * Exact integral from a to b, from the antiderivative x^4/4 + x^2 + ln x.
+     */
+    static double exact(double a, double b) {
+        auto F = [](long double x) { return x * x * x * x / 4 + x * x + logl(x); };
+        return F(b) - F(a);
+    }
+};
+
+int lab_01();
@@ -0,0 +1,338 @@
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
+#include "loader.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LOADER_MMAP
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile(const string &path, string *error) {
+    auto fail = [&](const string &reason) {
+        if (error)
+            *error = "cannot read " + path + ": " + reason;
+    };
+
+#ifdef LOADER_MMAP
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info{};
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        fail(strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return;
+    }
+    // directories, pipes and devices have no size to map or read up front
+    if (!S_ISREG(info.st_mode)) {
+        fail("not a regular file");
+        close(fd);
+        return;
+    }
+
+    if (info.st_size > 0) {
+        void *address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            // the file is read front to back once
+            madvise(address, info.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(address);
+            size = info.st_size;
+            mapped = true;
+        }
+    }
+    close(fd);
+    if (mapped || info.st_size == 0) {
+        opened = true;
+        return;
+    }
+#endif
+
+    error_code ec;
+    if (!filesystem::is_regular_file(path, ec)) {
+        fail(ec ? ec.message() : "not a regular file");
+        return;
+    }
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) {
+        fail(strerror(errno));
+        return;
+    }
+    // read to the end rather than trusting ftell, which reports nonsense sizes for directories
+    char chunk[1 << 16];
+    for (size_t n; (n = fread(chunk, 1, sizeof(chunk), f)) > 0;)
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    bool failed = ferror(f);
+    fclose(f);
+    if (failed) {
+        fail(strerror(errno));
+        buffer.clear();
+        return;
+    }
+
+    data = buffer.data();
+    size = buffer.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile() {
+#ifdef LOADER_MMAP
+    if (mapped)
+        munmap(const_cast<char *>(data), size);
+#endif
+}
+
+Project<double> ProjectTable::getProject(size_t p) const {
+    auto vector = [](span<const double> s) { return std::vector<double>(s.begin(), s.end()); };
+    return {string(getName(p)), vector(getYear(p)), vector(getOperatingCost(p)), vector(getCapitalCost(p)),
+            vector(getRevenue(p)), getTaxRate(p), getDiscountRate(p)};
+}
+
+void ProjectTable::addTo(Portfolio &portfolio) const {
+    for (size_t p = 0; p < size(); ++p)
+        portfolio.add(string(getName(p)), getYear(p), getOperatingCost(p), getCapitalCost(p), getRevenue(p),
+                      getTaxRate(p), getDiscountRate(p));
+}
+
+/**
+ * @brief Parses one number at `at` and moves past the comma after it; the last field of a row
+ * must instead run up to the end of the line.
+ *
+ * @param end - the end of the line
+ * @param last - whether this is the last field of the row
+ * @return false if the field is not a number followed by exactly that separator
+ */
+static bool parseNumber(const char *&at, const char *end, double &value, bool last) {
+    while (at < end && *at == ' ')
+        ++at;
+    auto [next, ec] = from_chars(at, end, value);
+    if (ec != errc())
+        return false;
+    at = next;
+    while (at < end && *at == ' ')
+        ++at;
+    if (last)
+        return at == end;
+    if (at == end || *at != ',')
+        return false;
+    ++at;
+    return true;
+}
+
+/**
+ * The columns of a parsed CSV file.
+ */
+struct CsvColumns {
+    vector<uint64_t> rowOffsets, nameOffsets;
+    vector<double> taxRate, discountRate, year, operatingCost, capitalCost, revenue;
+    string names;
+};
+
+bool loadProjectsCsv(const string &path, ProjectTable &table, string *error) {
+    MappedFile file(path, error);
+    if (!file.isOpen())
+        return false;
+
+    auto columns = make_shared<CsvColumns>();
+    const char *at = file.getData(), *end = at + file.getSize();
+    string_view previous;
+    unordered_set<string_view> seen;
+    string problem = "expected name,year,operating_cost,capital_cost,revenue,tax_rate,discount_rate";
+    size_t line = 0;
+
+    while (at < end) {
+        const char *eol = static_cast<const char *>(memchr(at, '\n', end - at));
+        if (!eol)
+            eol = end;
+        ++line;
+
+        const char *stop = eol > at && eol[-1] == '\r' ? eol - 1 : eol;
+        string_view text(at, stop - at);
+        if (text.empty() || (line == 1 && text.starts_with("name,"))) {
+            at = eol + 1;
+            continue;
+        }
+
+        // the name, optionally quoted
+        string_view name;
+        const char *field = at;
+        if (*field == '"') {
+            const char *close = static_cast<const char *>(memchr(field + 1, '"', stop - field - 1));
+            if (!close)
+                break;
+            name = string_view(field + 1, close - field - 1);
+            field = close + 1;
+        } else {
+            const char *comma = static_cast<const char *>(memchr(field, ',', stop - field));
+            if (!comma)
+                break;
+            name = string_view(field, comma - field);
+            field = comma;
+        }
+        if (field >= stop || *field != ',')
+            break;
+        ++field;
+
+        double values[6];
+        bool ok = true;
+        for (int k = 0; k < 6; ++k)
+            ok = ok && parseNumber(field, stop, values[k], k == 5);
+        if (!ok)
+            break;
+
+        if (columns->taxRate.empty() || name != previous) {
+            if (!seen.insert(name).second) {
+                problem = "rows of project \"" + string(name) + "\" are not contiguous";
+                break;
+            }
+            columns->rowOffsets.push_back(columns->year.size());
+            columns->nameOffsets.push_back(columns->names.size());
+            columns->names.append(name);
+            columns->taxRate.push_back(values[4]);
+            columns->discountRate.push_back(values[5]);
+            previous = name;
+        } else if (values[4] != columns->taxRate.back() || values[5] != columns->discountRate.back()) {
+            problem = "tax or discount rate differs from earlier rows of project \"" + string(name) + "\"";
+            break;
+        }
+        columns->year.push_back(values[0]);
+        columns->operatingCost.push_back(values[1]);
+        columns->capitalCost.push_back(values[2]);
+        columns->revenue.push_back(values[3]);
+
+        at = eol + 1;
+    }
+
+    if (at < end) {
+        if (error)
+            *error = path + ":" + to_string(line) + ": " + problem;
+        return false;
+    }
+
+    columns->rowOffsets.push_back(columns->year.size());
+    columns->nameOffsets.push_back(columns->names.size());
+
+    table = ProjectTable();
+    table.rowOffsets = columns->rowOffsets;
+    table.nameOffsets = columns->nameOffsets;
+    table.taxRate = columns->taxRate;
+    table.discountRate = columns->discountRate;
+    table.year = columns->year;
+    table.operatingCost = columns->operatingCost;
+    table.capitalCost = columns->capitalCost;
+    table.revenue = columns->revenue;
+    table.names = columns->names;
+    table.storage = columns;
+
+    return true;
+}
+
+static const char columnarMagic[8] = {'N', 'M', 'L', 'P', 'R', 'O', 'J', '2'};
+static const uint64_t columnarByteOrder = 0x0102030405060708;
+
+bool loadProjectsColumnar(const string &path, ProjectTable &table, string *error) {
+    auto file = make_shared<MappedFile>(path, error);
+    if (!file->isOpen())
+        return false;
+
+    auto fail = [&](const string &reason) {
+        if (error)
+            *error = path + ": " + reason;
+        return false;
+    };
+
+    const char *data = file->getData();
+    size_t size = file->getSize();
+    if (size < 40 || memcmp(data, columnarMagic, 8) != 0)
+        return fail("not a columnar project file");
+
+    // the mapping is page aligned and every section a multiple of 8 bytes, so the arrays can be used in place
+    auto header = reinterpret_cast<const uint64_t *>(data);
+    if (header[1] != columnarByteOrder)
+        return fail("written with a different byte order");
+    uint64_t projects = header[2], rows = header[3], nameBytes = header[4];
+    uint64_t words = 5 + 2 * (projects + 1) + 2 * projects + 4 * rows;
+    if (projects > size / 8 || rows > size / 8 || nameBytes > size || words * 8 + nameBytes > size)
+        return fail("truncated");
+
+    const uint64_t *rowOffsets = header + 5, *nameOffsets = rowOffsets + projects + 1;
+    const double *values = reinterpret_cast<const double *>(nameOffsets + projects + 1);
+    for (uint64_t p = 0; p < projects; ++p)
+        if (rowOffsets[p] > rowOffsets[p + 1] || nameOffsets[p] > nameOffsets[p + 1])
+            return fail("offsets out of order");
+    if (rowOffsets[0] != 0 || nameOffsets[0] != 0 || rowOffsets[projects] > rows || nameOffsets[projects] > nameBytes)
+        return fail("offsets out of range");
+
+    table = ProjectTable();
+    table.rowOffsets = span(rowOffsets, projects + 1);
+    table.nameOffsets = span(nameOffsets, projects + 1);
+    table.taxRate = span(values, projects);
+    table.discountRate = span(values + projects, projects);
+    table.year = span(values + 2 * projects, rows);
+    table.operatingCost = span(values + 2 * projects + rows, rows);
+    table.capitalCost = span(values + 2 * projects + 2 * rows, rows);
+    table.revenue = span(values + 2 * projects + 3 * rows, rows);
+    table.names = string_view(data + words * 8, nameBytes);
+    table.storage = file;
+    return true;
+}
+
+bool writeColumnar(const string &path, const ProjectTable &table, string *error) {
+    string temporary = path + ".tmp";
+    FILE *f = fopen(temporary.c_str(), "wb");
+    if (!f) {
+        if (error)
+            *error = "cannot create " + temporary;
+        return false;
+    }
+
+    uint64_t projects = table.size(), rows = table.getRows();
+    vector<uint64_t> header = {columnarByteOrder, projects, rows, 0};
+    vector<uint64_t> rowOffsets = {0}, nameOffsets = {0};
+    string names;
+    for (size_t p = 0; p < projects; ++p) {
+        rowOffsets.push_back(rowOffsets.back() + table.getYear(p).size());
+        names.append(table.getName(p));
+        nameOffsets.push_back(names.size());
+    }
+    header[3] = names.size();
+
+    vector<double> taxRate, discountRate, columns[4];
+    for (size_t p = 0; p < projects; ++p) {
+        taxRate.push_back(table.getTaxRate(p));
+        discountRate.push_back(table.getDiscountRate(p));
+        for (auto [column, values]: {pair{0, table.getYear(p)}, pair{1, table.getOperatingCost(p)},
+                                     pair{2, table.getCapitalCost(p)}, pair{3, table.getRevenue(p)}})
+            columns[column].insert(columns[column].end(), values.begin(), values.end());
+    }
+
+    bool ok = fwrite(columnarMagic, 1, 8, f) == 8;
+    auto write = [&](const auto &v) {
+        ok = ok && fwrite(v.data(), sizeof(v[0]), v.size(), f) == v.size();
+    };
+    write(header);
+    write(rowOffsets);
+    write(nameOffsets);
+    write(taxRate);
+    write(discountRate);
+    for (auto &column: columns)
+        write(column);
+    write(names);
+    ok = fclose(f) == 0 && ok;
+
+    // only a complete file replaces path
+    ok = ok && rename(temporary.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        remove(temporary.c_str());
+        if (error)
+            *error = "cannot write " + path;
+    }
+    return ok;
+}
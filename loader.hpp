@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "portfolio.hpp"
+#include "project.hpp"
+
+/**
+ * A read-only view of a whole file, memory-mapped where the platform supports it and read into
+ * a buffer otherwise.
+ */
+class MappedFile {
+public:
+    /**
+     * @param path - the file to open
+     * @param error - receives the reason when the file cannot be opened
+     */
+    MappedFile(const std::string &path, std::string *error);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    const char *getData() const {
+        return data;
+    }
+
+    std::size_t getSize() const {
+        return size;
+    }
+
+private:
+    const char *data = nullptr;
+    std::size_t size = 0;
+    bool opened = false;
+    bool mapped = false;
+    std::vector<char> buffer;
+};
+
+/**
+ * Many projects' cash-flow tables in long format: one row per (project, year), the rows of each
+ * project contiguous. The columns are spans, either over vectors the table owns (parsed CSV)
+ * or straight into a memory-mapped columnar file, so reading a project hands out views and
+ * copies nothing.
+ *
+ * CSV files have the header
+ *
+ *   name,year,operating_cost,capital_cost,revenue,tax_rate,discount_rate
+ *
+ * and a new project starts whenever the name changes. A project's rows must be contiguous and
+ * agree on the tax and discount rates. Columnar files are written by writeColumnar in the byte
+ * order of the machine, recorded as a byte-order mark, and laid out as
+ *
+ *   "NMLPROJ2", 0x0102030405060708, projects, rows, name bytes  (u64 each after the magic)
+ *   row offsets [projects + 1], name offsets [projects + 1]     (u64)
+ *   tax rates [projects], discount rates [projects]             (f64)
+ *   year, operating cost, capital cost, revenue [rows]          (f64)
+ *   names                                                       (bytes)
+ */
+class ProjectTable {
+public:
+    std::size_t size() const {
+        return taxRate.size();
+    }
+
+    std::size_t getRows() const {
+        return year.size();
+    }
+
+    std::string_view getName(std::size_t p) const {
+        return names.substr(nameOffsets[p], nameOffsets[p + 1] - nameOffsets[p]);
+    }
+
+    std::span<const double> getYear(std::size_t p) const {
+        return rows(year, p);
+    }
+
+    std::span<const double> getOperatingCost(std::size_t p) const {
+        return rows(operatingCost, p);
+    }
+
+    std::span<const double> getCapitalCost(std::size_t p) const {
+        return rows(capitalCost, p);
+    }
+
+    std::span<const double> getRevenue(std::size_t p) const {
+        return rows(revenue, p);
+    }
+
+    double getTaxRate(std::size_t p) const {
+        return taxRate[p];
+    }
+
+    double getDiscountRate(std::size_t p) const {
+        return discountRate[p];
+    }
+
+    /**
+     * @brief Builds project p as a Project; its columns are copied once, into the Project's own vectors.
+     */
+    Project<double> getProject(std::size_t p) const;
+
+    /**
+     * @brief Adds every project to a portfolio, passing the columns as views.
+     */
+    void addTo(Portfolio &portfolio) const;
+
+    friend bool loadProjectsCsv(const std::string &path, ProjectTable &table, std::string *error);
+
+    friend bool loadProjectsColumnar(const std::string &path, ProjectTable &table, std::string *error);
+
+private:
+    std::span<const double> rows(std::span<const double> column, std::size_t p) const {
+        return column.subspan(rowOffsets[p], rowOffsets[p + 1] - rowOffsets[p]);
+    }
+
+    std::span<const std::uint64_t> rowOffsets, nameOffsets;
+    std::span<const double> taxRate, discountRate, year, operatingCost, capitalCost, revenue;
+    std::string_view names;
+
+    // what the views point into, the parsed columns of a CSV file or the mapping of a columnar one;
+    // shared, so copies of the table stay valid
+    std::shared_ptr<const void> storage;
+};
+
+/**
+ * @brief Loads a CSV file of project cash flows, parsing numbers with std::from_chars.
+ *
+ * @param path - the file to load
+ * @param table - receives the projects
+ * @param error - receives the reason and line number when the file cannot be loaded
+ * @return true if the file was loaded, the table is left as it was otherwise
+ */
+bool loadProjectsCsv(const std::string &path, ProjectTable &table, std::string *error);
+
+/**
+ * @brief Maps a columnar project file; the table's columns point into the mapping.
+ *
+ * @return true if the file was loaded, false if it is malformed or was written with the other byte order
+ */
+bool loadProjectsColumnar(const std::string &path, ProjectTable &table, std::string *error);
+
+/**
+ * @brief Writes a table in the columnar format.
+ *
+ * The file is written under a temporary name next to path and renamed over it once complete,
+ * so a failed write leaves no truncated file behind.
+ *
+ * @return true if the file was written
+ */
+bool writeColumnar(const std::string &path, const ProjectTable &table, std::string *error);
@@ -1,77 +1,29 @@
 #include <vector>
 #include <valarray>
 #include <iostream>
+#include "irr.hpp"
+#include "project.hpp"
+#include "risk.hpp"
 
 #define ND 0
-#define MAX_ITERATIONS 10000
 
 using namespace std;
 
-template<typename T>
-class Project {
-public:
-    Project(const string &name,
-            const vector<T> &year,
-            const vector<T> &operating_cost,
-            const vector<T> &capital_cost,
-            const vector<T> &revenue,
-            const T tax_rate,
-            const T discount_rate
-    ) {
-        this->name = name;
-        this->year = year;
-        this->operating_cost = operating_cost;
-        this->capital_cost = capital_cost;
-        this->revenue = revenue;
-        this->discount_rate = discount_rate;
-        this->tax_rate = tax_rate;
+/**
+ * @brief Prints a project's IRR from the bracketed solver, noting when it is not a unique, converged root.
+ */
+void printIrr(const IrrResult &result) {
+    if (result.status == IrrStatus::NoRoot) {
+        cout << "IRR: none (no sign change in the NPV)" << endl << endl;
+        return;
     }
-
-    float getNpv() {
-        float npv = 0.0;
-        for (int i = 0; i < year.size(); ++i) {
-            auto cf = ((revenue[i] - operating_cost[i]) * (1 - tax_rate / 100) - capital_cost[i]);
-            npv += cf / pow(1 + discount_rate / 100, year[i]);
-        }
-        return npv;
-    }
-
-    float getIrr() {
-        float r = 2;
-        float eps = 0.01;
-
-        for (int x = 0; x < MAX_ITERATIONS; ++x) {
-            float n = 0.0;
-            float d = 0.0;
-            for (int i = 0; i < year.size(); ++i) {
-                auto cf = ((revenue[i] - operating_cost[i]) * (1 - tax_rate / 100) - capital_cost[i]);
-                n += cf / pow(1 + r / 100, year[i]);
-                d += ((-year[i]) * cf) / pow(1 + r / 100, year[i] + 1);
-            }
-
-            if (abs(n / d) < eps)
-                return r;
-            else
-                r -= n / d;
-        }
-
-        return r;
-    }
-
-    string getName() {
-        return name;
-    }
-
-private:
-    string name;
-    vector<T> year;
-    vector<T> operating_cost;
-    vector<T> capital_cost;
-    vector<T> revenue;
-    T discount_rate;
-    T tax_rate;
-};
-
+    cout << "IRR: " << result.rate;
+    if (result.status == IrrStatus::NotConverged)
+        cout << " (not converged)";
+    if (!result.unique)
+        cout << " (one of several)";
+    cout << endl << endl;
+}
 
 int main() {
 
@@ -84,7 +36,7 @@ int main() {
 
     cout << p1.getName() << endl;
     cout << "NPV: " << p1.getNpv() << endl;
-    cout << "IRR: " << p1.getIrr() << endl << endl;
+    printIrr(irr(p1));
 
 
     Project p2 = Project("Ekchakra Coal Block",
@@ -96,7 +48,7 @@ int main() {
 
     cout << p2.getName() << endl;
     cout << "NPV: " << p2.getNpv() << endl;
-    cout << "IRR: " << p2.getIrr() << endl << endl;
+    printIrr(irr(p2));
 
     Project p3 = Project("Remuna Coal Block",
                          {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
@@ -107,7 +59,7 @@ int main() {
 
     cout << p3.getName() << endl;
     cout << "NPV: " << p3.getNpv() << endl;
-    cout << "IRR: " << p3.getIrr() << endl << endl;
+    printIrr(irr(p3));
 
     Project p4 = Project("Bhadradri Coal Block",
                          {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10},
@@ -118,8 +70,18 @@ int main() {
 
     cout << p4.getName() << endl;
     cout << "NPV: " << p4.getNpv() << endl;
-    cout << "IRR: " << p4.getIrr() << endl;
-
+    printIrr(irr(p4));
+
+    // NPV under uncertain prices, costs, tax and discount rates
+    ThreadPool pool;
+    long long scenarios = 100000;
+    cout << "Monte Carlo NPV (" << scenarios << " scenarios)" << endl;
+    unsigned stream = 0;
+    for (auto *p: {&p1, &p2, &p3, &p4}) {
+        RiskResult risk = simulateNpv(*p, RiskModel(), scenarios, &pool, 0, stream++);
+        cout << p->getName() << ": P10: " << risk.p10 << " P50: " << risk.p50 << " P90: " << risk.p90
+             << " P(NPV < 0): " << risk.probabilityOfLoss << endl;
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "adaptive_quadrature.hpp"
+#include "cubature.hpp"
+#include "thread_pool.hpp"
+
+#define MONTE_CARLO_CHUNK 4096          // points per task, fixed so results do not depend on the thread count
+#define MONTE_CARLO_FIRST_ROUND 16384   // points in the first round, each later round doubles the total
+#define MONTE_CARLO_REPLICATES 8        // randomly shifted copies of a QMC sequence for its error estimate
+#define LOW_DISCREPANCY_MAX_DIMENSIONS 16
+
+/**
+ * Where the sample points come from.
+ *
+ * Pseudo: Philox random numbers, error falls like 1/sqrt(N).
+ * Halton: radical inverses in the first primes, error close to 1/N for smooth integrands in low dimension.
+ * Sobol:  Sobol' sequence with Joe-Kuo direction numbers, error close to 1/N and best at N = 2^m.
+ */
+enum class Sampler {
+    Pseudo,
+    Halton,
+    Sobol
+};
+
+/**
+ * @brief Philox-4x32-10 (Salmon et al., 2011): a counter-based generator, so the random numbers
+ * for any sample index and stream can be computed directly, in any order and on any thread.
+ */
+inline std::array<std::uint32_t, 4> philox4x32(std::array<std::uint32_t, 4> counter, std::uint32_t k0, std::uint32_t k1) {
+    for (int round = 0; round < 10; ++round) {
+        std::uint64_t p0 = (std::uint64_t) 0xD2511F53u * counter[0];
+        std::uint64_t p1 = (std::uint64_t) 0xCD9E8D57u * counter[2];
+        counter = {(std::uint32_t) (p1 >> 32) ^ counter[1] ^ k0, (std::uint32_t) p1,
+                   (std::uint32_t) (p0 >> 32) ^ counter[3] ^ k1, (std::uint32_t) p0};
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+
+    return counter;
+}
+
+/**
+ * @brief Maps 64 random bits to a double in [0, 1) with 53 significant bits.
+ */
+inline double uniformFromBits(std::uint32_t hi, std::uint32_t lo) {
+    return (double) ((((std::uint64_t) hi << 32) | lo) >> 11) * 0x1p-53;
+}
+
+/**
+ * Pseudo-random points in the unit cube. Point i of stream s is Philox of the counter
+ * (i, dimension pair, s) under the seed, so every stream is reproducible on its own.
+ */
+class PhiloxPoints {
+public:
+    PhiloxPoints(std::size_t dimensions, std::uint64_t seed, std::uint32_t stream = 0)
+            : dimensions(dimensions), k0((std::uint32_t) seed), k1((std::uint32_t) (seed >> 32)), stream(stream) {}
+
+    /**
+     * @brief Fills u[d][k] with coordinate d of point first + k, k = 0..n-1.
+     */
+    void fill(long long first, std::size_t n, double *const *u) const {
+        for (std::size_t d = 0; d < dimensions; d += 2) {
+            double *u0 = u[d], *u1 = d + 1 < dimensions ? u[d + 1] : nullptr;
+#pragma omp simd
+            for (std::size_t k = 0; k < n; ++k) {
+                std::uint64_t index = first + k;
+                auto bits = philox4x32({(std::uint32_t) index, (std::uint32_t) (index >> 32), (std::uint32_t) d, stream}, k0, k1);
+                u0[k] = uniformFromBits(bits[0], bits[1]);
+                if (u1)
+                    u1[k] = uniformFromBits(bits[2], bits[3]);
+            }
+        }
+    }
+
+private:
+    std::size_t dimensions;
+    std::uint32_t k0, k1, stream;
+};
+
+/**
+ * Halton points: coordinate d of point i is the radical inverse of i + 1 in the d-th prime.
+ */
+class HaltonPoints {
+public:
+    explicit HaltonPoints(std::size_t dimensions) : dimensions(dimensions) {}
+
+    void fill(long long first, std::size_t n, double *const *u) const {
+        static const int primes[LOW_DISCREPANCY_MAX_DIMENSIONS] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53};
+
+        for (std::size_t d = 0; d < dimensions; ++d) {
+            int base = primes[d];
+            for (std::size_t k = 0; k < n; ++k) {
+                unsigned long long i = first + k + 1;
+                double x = 0, scale = 1.0 / base;
+                for (; i > 0; i /= base, scale /= base)
+                    x += (double) (i % base) * scale;
+                u[d][k] = x;
+            }
+        }
+    }
+
+private:
+    std::size_t dimensions;
+};
+
+/**
+ * Sobol' points in Gray-code order, with the direction numbers of Joe and Kuo (2008).
+ */
+class SobolPoints {
+public:
+    explicit SobolPoints(std::size_t dimensions) : dimensions(dimensions), directions(dimensions) {
+        // degree s, coefficients a and initial m_1..m_s of the primitive polynomials for dimensions 2..16
+        static const struct {
+            int s, a, m[6];
+        } polynomials[LOW_DISCREPANCY_MAX_DIMENSIONS - 1] = {
+                {1, 0,  {1}},
+                {2, 1,  {1, 3}},
+                {3, 1,  {1, 3, 1}},
+                {3, 2,  {1, 1, 1}},
+                {4, 1,  {1, 1, 3, 3}},
+                {4, 4,  {1, 3, 5, 13}},
+                {5, 2,  {1, 1, 5, 5, 17}},
+                {5, 4,  {1, 1, 5, 5, 5}},
+                {5, 7,  {1, 1, 7, 11, 19}},
+                {5, 11, {1, 1, 5, 1, 1}},
+                {5, 13, {1, 1, 1, 3, 11}},
+                {5, 14, {1, 3, 5, 5, 31}},
+                {6, 1,  {1, 3, 3, 9, 7, 49}},
+                {6, 13, {1, 1, 1, 15, 21, 21}},
+                {6, 16, {1, 3, 1, 13, 27, 49}},
+        };
+
+        for (std::size_t d = 0; d < dimensions; ++d) {
+            auto &v = directions[d];
+            if (d == 0) {
+                for (int i = 0; i < 32; ++i)
+                    v[i] = 1u << (31 - i);
+                continue;
+            }
+
+            auto &p = polynomials[d - 1];
+            for (int i = 0; i < 32; ++i) {
+                if (i < p.s) {
+                    v[i] = (std::uint32_t) p.m[i] << (31 - i);
+                } else {
+                    v[i] = v[i - p.s] ^ (v[i - p.s] >> p.s);
+                    for (int k = 1; k < p.s; ++k)
+                        if ((p.a >> (p.s - 1 - k)) & 1)
+                            v[i] ^= v[i - k];
+                }
+            }
+        }
+    }
+
+    void fill(long long first, std::size_t n, double *const *u) const {
+        for (std::size_t d = 0; d < dimensions; ++d) {
+            auto &v = directions[d];
+
+            // point i is the XOR of the directions selected by the Gray code of i, after which
+            // each step flips a single direction
+            std::uint64_t gray = first ^ (first >> 1);
+            std::uint32_t x = 0;
+            for (int bit = 0; bit < 32; ++bit)
+                if ((gray >> bit) & 1)
+                    x ^= v[bit];
+
+            for (std::size_t k = 0; k < n; ++k) {
+                u[d][k] = x * 0x1p-32;
+                x ^= v[std::countr_zero((std::uint64_t) (first + k + 1))];
+            }
+        }
+    }
+
+private:
+    std::size_t dimensions;
+    std::vector<std::array<std::uint32_t, 32>> directions;
+};
+
+/**
+ * @brief Evaluates f at n points given one coordinate array per dimension. One-dimensional
+ * integrands such as F1 and F2 go through their own (batched) eval.
+ */
+template<std::size_t D, typename F>
+void evalSamples(const F &f, const double *const *x, double *y, std::size_t n) {
+    if constexpr (D == 1 && Integrand<const F>)
+        evalPoints(f, x[0], y, n);
+    else
+        evalCubaturePoints<D>(f, x, y, n);
+}
+
+/**
+ * Mean and sum of squared deviations of a set of samples, mergeable in any grouping.
+ */
+struct SampleStatistics {
+    long long count = 0;
+    double mean = 0, m2 = 0;
+
+    /**
+     * @brief Chan et al.'s pairwise update for two disjoint sets of samples.
+     */
+    void merge(const SampleStatistics &other) {
+        if (other.count == 0)
+            return;
+        long long total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * ((double) count * other.count / total);
+        count = total;
+    }
+};
+
+/**
+ * @brief Integrates f over a box by Monte Carlo or randomized quasi-Monte Carlo sampling.
+ *
+ * Samples are drawn in rounds that double the total each time until the estimated error is
+ * below the tolerance or maxSamples is reached. A round is split into chunks of
+ * MONTE_CARLO_CHUNK points that run as pool tasks; each chunk generates, scales and evaluates
+ * its points QUADRATURE_BATCH_SIZE at a time. Every point is addressed by its index, and
+ * chunk statistics are merged in order, so the same seed gives the same result on any number
+ * of threads.
+ *
+ * For Pseudo the error is the standard error of the sample mean. For Halton and Sobol the
+ * sequence is used MONTE_CARLO_REPLICATES times, each under its own random shift modulo 1
+ * (Cranley-Patterson rotation), and the error is the standard error of the replicate means.
+ * A budget below two pseudo-random points, or below one point per replicate, leaves the error
+ * infinite and the result unconverged.
+ *
+ * @param f - the function to integrate, a Point<D> integrand or, for D = 1, a plain integrand
+ * @param a - the lower corner of the box
+ * @param b - the upper corner of the box
+ * @param sampler - the point set to use
+ * @param tolerance - the standard error to reach
+ * @param maxSamples - the limit on integrand evaluations
+ * @param pool - the pool to run the chunks on, or nullptr to run on the calling thread
+ * @param seed - seed of the random numbers and shifts
+ * @return the estimate, its standard error, the evaluation count and whether the tolerance was met
+ */
+template<std::size_t D, typename F>
+QuadratureResult monteCarlo(const F &f, const Point<D> &a, const Point<D> &b, Sampler sampler, double tolerance,
+                            long long maxSamples, ThreadPool *pool = nullptr, std::uint64_t seed = 0) {
+    static_assert(D >= 1 && D <= LOW_DISCREPANCY_MAX_DIMENSIONS, "the low-discrepancy tables cover 16 dimensions");
+
+    double volume = 1;
+    for (std::size_t d = 0; d < D; ++d)
+        volume *= b[d] - a[d];
+
+    PhiloxPoints pseudo(D, seed);
+    HaltonPoints halton(D);
+    SobolPoints sobol(D);
+
+    // the random shifts of the QMC replicates come from their own Philox stream
+    int replicates = sampler == Sampler::Pseudo ? 1 : MONTE_CARLO_REPLICATES;
+    std::vector<Point<D>> shifts(replicates);
+    for (int r = 0; r < replicates; ++r) {
+        double *u[D];
+        for (std::size_t d = 0; d < D; ++d)
+            u[d] = &shifts[r][d];
+        PhiloxPoints(D, seed, 1u + r).fill(0, 1, u);
+    }
+
+    std::vector<SampleStatistics> totals(replicates);
+    QuadratureResult result;
+    long long points = 0;
+
+    // with fewer than two samples there is no spread to estimate, so the error stays unbounded
+    result.error = std::numeric_limits<double>::infinity();
+
+    auto chunk = [&](long long first, long long last, SampleStatistics *stats) {
+        double coords[D][QUADRATURE_BATCH_SIZE];
+        double *u[D];
+        double y[QUADRATURE_BATCH_SIZE];
+        for (std::size_t d = 0; d < D; ++d)
+            u[d] = coords[d];
+
+        for (int r = 0; r < replicates; ++r)
+            for (long long i = first; i < last; i += QUADRATURE_BATCH_SIZE) {
+                std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, last - i);
+
+                if (sampler == Sampler::Pseudo)
+                    pseudo.fill(i, m, u);
+                else if (sampler == Sampler::Halton)
+                    halton.fill(i, m, u);
+                else
+                    sobol.fill(i, m, u);
+
+                for (std::size_t d = 0; d < D; ++d) {
+                    double shift = sampler == Sampler::Pseudo ? 0 : shifts[r][d];
+                    double lo = a[d], width = b[d] - a[d];
+#pragma omp simd
+                    for (std::size_t k = 0; k < m; ++k) {
+                        double s = coords[d][k] + shift;
+                        coords[d][k] = lo + width * (s >= 1 ? s - 1 : s);
+                    }
+                }
+
+                evalSamples<D>(f, u, y, m);
+
+                SampleStatistics block;
+                block.count = m;
+                for (std::size_t k = 0; k < m; ++k)
+                    block.mean += y[k];
+                block.mean /= m;
+                for (std::size_t k = 0; k < m; ++k)
+                    block.m2 += (y[k] - block.mean) * (y[k] - block.mean);
+                stats[r].merge(block);
+            }
+    };
+
+    long long round = MONTE_CARLO_FIRST_ROUND;
+    while (true) {
+        round = std::min(round, std::max<long long>(maxSamples / replicates - points, 0));
+        if (round == 0)
+            break;
+
+        std::size_t chunks = (round + MONTE_CARLO_CHUNK - 1) / MONTE_CARLO_CHUNK;
+        std::vector<SampleStatistics> stats(chunks * replicates);
+        auto run = [&](std::size_t c) {
+            long long first = points + (long long) c * MONTE_CARLO_CHUNK;
+            chunk(first, std::min(first + MONTE_CARLO_CHUNK, points + round), &stats[c * replicates]);
+        };
+        if (pool)
+            pool->parallelFor(0, chunks, 1, run);
+        else
+            for (std::size_t c = 0; c < chunks; ++c)
+                run(c);
+
+        for (std::size_t c = 0; c < chunks; ++c)
+            for (int r = 0; r < replicates; ++r)
+                totals[r].merge(stats[c * replicates + r]);
+        points += round;
+
+        if (sampler == Sampler::Pseudo) {
+            result.value = volume * totals[0].mean;
+            if (points >= 2)
+                result.error = volume * std::sqrt(totals[0].m2 / (points - 1) / points);
+        } else {
+            SampleStatistics means;
+            for (auto &total: totals)
+                means.merge({1, total.mean, 0});
+            result.value = volume * means.mean;
+            result.error = volume * std::sqrt(means.m2 / (replicates - 1) / replicates);
+        }
+
+        if (result.error <= tolerance)
+            break;
+        round = points;
+    }
+
+    result.evaluations = points * replicates;
+    result.converged = result.error <= tolerance;
+
+    return result;
+}
+
+/**
+ * @brief One-dimensional Monte Carlo integration of an F1/F2-style integrand from a to b.
+ */
+template<Integrand F>
+QuadratureResult monteCarlo(const F &f, double a, double b, Sampler sampler, double tolerance, long long maxSamples,
+                            ThreadPool *pool = nullptr, std::uint64_t seed = 0) {
+    return monteCarlo<1>(f, {a}, {b}, sampler, tolerance, maxSamples, pool, seed);
+}
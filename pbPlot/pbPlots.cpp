@@ -2,6 +2,26 @@
 
 #include "pbPlots.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <queue>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PBPLOTS_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <arm_neon.h>
+#define PBPLOTS_ARM_SIMD 1
+#if defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+#endif
+
 using namespace std;
 
 #ifndef M_PI
@@ -145,7 +165,9 @@ RGBABitmapImageReference *CreateRGBABitmapImageReference(){
 
     reference = new RGBABitmapImageReference();
     reference->image = new RGBABitmapImage();
-    reference->image->x = new vector<RGBABitmap*> (0.0);
+    reference->image->width = 0;
+    reference->image->height = 0;
+    reference->image->pixels = new vector<RGBAPixel> (0);
 
     return reference;
 }
@@ -1822,84 +1844,64 @@ RGBA *CreateRGBAColor(double r, double g, double b, double a){
 }
 RGBABitmapImage *CreateImage(double w, double h, RGBA *color){
     RGBABitmapImage *image;
-    double i, j;
+    RGBAPixel fill;
+
+    fill.r = color->r;
+    fill.g = color->g;
+    fill.b = color->b;
+    fill.a = color->a;
 
     image = new RGBABitmapImage();
-    image->x = new vector<RGBABitmap*> (w);
-    for(i = 0.0; i < w; i = i + 1.0){
-        image->x->at(i) = new RGBABitmap();
-        image->x->at(i)->y = new vector<RGBA*> (h);
-        for(j = 0.0; j < h; j = j + 1.0){
-            image->x->at(i)->y->at(j) = new RGBA();
-            SetPixel(image, i, j, color);
-        }
-    }
+    image->width = w;
+    image->height = h;
+    image->pixels = new vector<RGBAPixel> (image->width*image->height, fill);
 
     return image;
 }
 void DeleteImage(RGBABitmapImage *image){
-    double i, j, w, h;
-
-    w = ImageWidth(image);
-    h = ImageHeight(image);
-
-    for(i = 0.0; i < w; i = i + 1.0){
-        for(j = 0.0; j < h; j = j + 1.0){
-            delete image->x->at(i)->y->at(j);
-        }
-        delete image->x->at(i);
-    }
+    delete image->pixels;
     delete image;
 }
 double ImageWidth(RGBABitmapImage *image){
-    return image->x->size();
+    return image->width;
 }
 double ImageHeight(RGBABitmapImage *image){
-    double height;
-
-    if(ImageWidth(image) == 0.0){
-        height = 0.0;
-    }else{
-        height = image->x->at(0)->y->size();
-    }
-
-    return height;
+    return image->height;
+}
+RGBAPixel *ImagePixelAt(RGBABitmapImage *image, double x, double y){
+    return image->pixels->data() + (size_t)y*image->width + (size_t)x;
 }
 void SetPixel(RGBABitmapImage *image, double x, double y, RGBA *color){
+    RGBAPixel *pixel;
+
     if(x >= 0.0 && x < ImageWidth(image) && y >= 0.0 && y < ImageHeight(image)){
-        image->x->at(x)->y->at(y)->a = color->a;
-        image->x->at(x)->y->at(y)->r = color->r;
-        image->x->at(x)->y->at(y)->g = color->g;
-        image->x->at(x)->y->at(y)->b = color->b;
+        pixel = ImagePixelAt(image, x, y);
+        pixel->a = color->a;
+        pixel->r = color->r;
+        pixel->g = color->g;
+        pixel->b = color->b;
     }
 }
 void DrawPixel(RGBABitmapImage *image, double x, double y, RGBA *color){
-    double ra, ga, ba, aa;
-    double rb, gb, bb, ab;
-    double ro, go, bo, ao;
-
     if(x >= 0.0 && x < ImageWidth(image) && y >= 0.0 && y < ImageHeight(image)){
-        ra = color->r;
-        ga = color->g;
-        ba = color->b;
-        aa = color->a;
-
-        rb = image->x->at(x)->y->at(y)->r;
-        gb = image->x->at(x)->y->at(y)->g;
-        bb = image->x->at(x)->y->at(y)->b;
-        ab = image->x->at(x)->y->at(y)->a;
+        BlendPixel(ImagePixelAt(image, x, y), color->r, color->g, color->b, color->a);
+    }
+}
+void BlendPixel(RGBAPixel *pixel, double ra, double ga, double ba, double aa){
+    double rb, gb, bb, ab;
+    double ao;
 
-        ao = CombineAlpha(aa, ab);
+    rb = pixel->r;
+    gb = pixel->g;
+    bb = pixel->b;
+    ab = pixel->a;
 
-        ro = AlphaBlend(ra, aa, rb, ab, ao);
-        go = AlphaBlend(ga, aa, gb, ab, ao);
-        bo = AlphaBlend(ba, aa, bb, ab, ao);
+    ao = CombineAlpha(aa, ab);
 
-        image->x->at(x)->y->at(y)->r = ro;
-        image->x->at(x)->y->at(y)->g = go;
-        image->x->at(x)->y->at(y)->b = bo;
-        image->x->at(x)->y->at(y)->a = ao;
-    }
+    pixel->r = AlphaBlend(ra, aa, rb, ab, ao);
+    pixel->g = AlphaBlend(ga, aa, gb, ab, ao);
+    pixel->b = AlphaBlend(ba, aa, bb, ab, ao);
+    pixel->a = ao;
 }
 double CombineAlpha(double as, double ad){
     return as + ad*(1.0 - as);
@@ -1928,13 +1930,22 @@ void DrawRectangle1px(RGBABitmapImage *image, double x, double y, double width,
     DrawHorizontalLine1px(image, x + 1.0, y + height, width + 1.0 - 2.0, color);
 }
 void DrawImageOnImage(RGBABitmapImage *dst, RGBABitmapImage *src, double topx, double topy){
-    double y, x;
+    double x0, x1, y0, y1, y, x;
+    RGBAPixel *s, *d;
 
-    for(y = 0.0; y < ImageHeight(src); y = y + 1.0){
-        for(x = 0.0; x < ImageWidth(src); x = x + 1.0){
-            if(topx + x >= 0.0 && topx + x < ImageWidth(dst) && topy + y >= 0.0 && topy + y < ImageHeight(dst)){
-                DrawPixel(dst, topx + x, topy + y, src->x->at(x)->y->at(y));
-            }
+    /* Clip the source rectangle against the destination once, then blend row by row. */
+    x0 = fmax(0.0, ceil(-topx));
+    y0 = fmax(0.0, ceil(-topy));
+    x1 = fmin(ImageWidth(src), ImageWidth(dst) - topx);
+    y1 = fmin(ImageHeight(src), ImageHeight(dst) - topy);
+
+    for(y = y0; y < y1; y = y + 1.0){
+        s = ImagePixelAt(src, x0, y);
+        d = ImagePixelAt(dst, topx + x0, topy + y);
+        for(x = x0; x < x1; x = x + 1.0){
+            BlendPixel(d, s->r, s->g, s->b, s->a);
+            s++;
+            d++;
         }
     }
 }
@@ -2100,24 +2111,28 @@ RGBABitmapImage *CopyImage(RGBABitmapImage *image){
 
     for(i = 0.0; i < ImageWidth(image); i = i + 1.0){
         for(j = 0.0; j < ImageHeight(image); j = j + 1.0){
-            SetPixel(copy, i, j, image->x->at(i)->y->at(j));
+            *ImagePixelAt(copy, i, j) = *ImagePixelAt(image, i, j);
         }
     }
 
     return copy;
 }
 RGBA *GetImagePixel(RGBABitmapImage *image, double x, double y){
-    return image->x->at(x)->y->at(y);
+    RGBAPixel *pixel;
+
+    pixel = ImagePixelAt(image, x, y);
+
+    return CreateRGBAColor(pixel->r, pixel->g, pixel->b, pixel->a);
 }
 void HorizontalFlip(RGBABitmapImage *img){
     double y, x;
-    double tmp;
-    RGBA *c1, *c2;
+    float tmp;
+    RGBAPixel *c1, *c2;
 
     for(y = 0.0; y < ImageHeight(img); y = y + 1.0){
-        for(x = 0.0; x < ImageWidth(img)/2.0; x = x + 1.0){
-            c1 = img->x->at(x)->y->at(y);
-            c2 = img->x->at(ImageWidth(img) - 1.0 - x)->y->at(y);
+        for(x = 0.0; x < floor(ImageWidth(img)/2.0); x = x + 1.0){
+            c1 = ImagePixelAt(img, x, y);
+            c2 = ImagePixelAt(img, ImageWidth(img) - 1.0 - x, y);
 
             tmp = c1->a;
             c1->a = c2->a;
@@ -2154,7 +2169,7 @@ RGBABitmapImage *RotateAntiClockwise90Degrees(RGBABitmapImage *image){
 
     for(y = 0.0; y < ImageHeight(image); y = y + 1.0){
         for(x = 0.0; x < ImageWidth(image); x = x + 1.0){
-            SetPixel(rotated, y, ImageWidth(image) - 1.0 - x, GetImagePixel(image, x, y));
+            *ImagePixelAt(rotated, y, ImageWidth(image) - 1.0 - x) = *ImagePixelAt(image, x, y);
         }
     }
 
@@ -2597,13 +2612,14 @@ RGBABitmapImage *Blur(RGBABitmapImage *src, double pixels){
 }
 RGBA *CreateBlurForPoint(RGBABitmapImage *src, double x, double y, double pixels){
     RGBA *rgba;
+    RGBAPixel *pixel;
     double i, j, countColor, countTransparent;
     double fromx, tox, fromy, toy;
     double w, h;
     double alpha;
 
-    w = src->x->size();
-    h = src->x->at(0)->y->size();
+    w = ImageWidth(src);
+    h = ImageHeight(src);
 
     rgba = new RGBA();
     rgba->r = 0.0;
@@ -2627,11 +2643,12 @@ RGBA *CreateBlurForPoint(RGBABitmapImage *src, double x, double y, double pixels
     countTransparent = 0.0;
     for(i = fromx; i < tox; i = i + 1.0){
         for(j = fromy; j < toy; j = j + 1.0){
-            alpha = src->x->at(i)->y->at(j)->a;
+            pixel = ImagePixelAt(src, i, j);
+            alpha = pixel->a;
             if(alpha > 0.0){
-                rgba->r = rgba->r + src->x->at(i)->y->at(j)->r;
-                rgba->g = rgba->g + src->x->at(i)->y->at(j)->g;
-                rgba->b = rgba->b + src->x->at(i)->y->at(j)->b;
+                rgba->r = rgba->r + pixel->r;
+                rgba->g = rgba->g + pixel->g;
+                rgba->b = rgba->b + pixel->b;
                 countColor = countColor + 1.0;
             }
             rgba->a = rgba->a + alpha;
@@ -4166,11 +4183,25 @@ void AssertStringArraysEqual(vector<StringReference*> *a, vector<StringReference
         failures->numberValue = failures->numberValue + 1.0;
     }
 }
-vector<double> *ConvertToPNG(RGBABitmapImage *image){
-    return ConvertToPNGWithOptions(image, 6.0, false, 0.0, 0.001);
+vector<unsigned char> *ConvertToPNG(RGBABitmapImage *image){
+    StringReference *errorMessages;
+    vector<unsigned char> *pngData;
+
+    errorMessages = CreateStringReference(toVector(L""));
+    pngData = ConvertToPNGWithOptions(image, 6.0, false, 0.0, 0.001, PNG_FILTER_ADAPTIVE, 1.0, errorMessages);
+    FreeStringReference(errorMessages);
+
+    return pngData;
 }
-vector<double> *ConvertToPNGGrayscale(RGBABitmapImage *image){
-    return ConvertToPNGWithOptions(image, 0.0, false, 0.0, 0.001);
+vector<unsigned char> *ConvertToPNGGrayscale(RGBABitmapImage *image){
+    StringReference *errorMessages;
+    vector<unsigned char> *pngData;
+
+    errorMessages = CreateStringReference(toVector(L""));
+    pngData = ConvertToPNGWithOptions(image, 0.0, false, 0.0, 0.001, PNG_FILTER_ADAPTIVE, 1.0, errorMessages);
+    FreeStringReference(errorMessages);
+
+    return pngData;
 }
 PHYS *PysicsHeader(double pixelsPerMeter){
     PHYS *phys;
@@ -4181,9 +4212,13 @@ PHYS *PysicsHeader(double pixelsPerMeter){
 
     return phys;
 }
-vector<double> *ConvertToPNGWithOptions(RGBABitmapImage *image, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel){
+vector<unsigned char> *ConvertToPNGWithOptions(RGBABitmapImage *image, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, double threads, StringReference *errorMessages){
     PNGImage *png;
-    vector<double> *pngData, *colorData;
+    vector<unsigned char> *pngData, *colorData;
+
+    if(!PNGFilterTypeValid(filterType, errorMessages)){
+        return NULL;
+    }
 
     png = new PNGImage();
 
@@ -4196,135 +4231,414 @@ vector<double> *ConvertToPNGWithOptions(RGBABitmapImage *image, double colorType
 
     if(colorType == 6.0){
         colorData = GetPNGColorData(image);
+        PNGFilterScanlines(colorData, ImageWidth(image), ImageHeight(image), 4.0, filterType);
     }else{
         colorData = GetPNGColorDataGreyscale(image);
+        PNGFilterScanlines(colorData, ImageWidth(image), ImageHeight(image), 1.0, filterType);
+    }
+    /* Levels up to 10 emit one fixed-Huffman block, levels above 10 emit dynamic-Huffman
+       blocks using the match finder settings of level - 10. Any thread count other than
+       1 compresses independent segments in parallel. A count of 0 or less uses every
+       hardware thread, and a fractional count is rounded down to at least one thread. */
+    if(threads != 1.0){
+        png->zlibStruct = ZLibCompressParallel(colorData, compressionLevel > 10.0 ? compressionLevel - 10.0 : compressionLevel, compressionLevel > 10.0, threads);
+    }else if(compressionLevel > 10.0){
+        png->zlibStruct = ZLibCompressDynamicHuffman(colorData, compressionLevel - 10.0);
+    }else{
+        png->zlibStruct = ZLibCompressStaticHuffman(colorData, compressionLevel);
     }
-    png->zlibStruct = ZLibCompressStaticHuffman(colorData, compressionLevel);
+    delete colorData;
 
     pngData = PNGSerializeChunks(png);
 
+    delete png->signature;
+    delete png->ihdr;
+    delete png->phys;
+    delete png->zlibStruct->CompressedDataBlocks;
+    delete png->zlibStruct;
+    delete png;
+
     return pngData;
 }
-vector<double> *PNGSerializeChunks(PNGImage *png){
-    double length, i, chunkLength;
-    vector<double> *data;
-    NumberReference *position;
+PNGStreamWriter *CreatePNGStreamWriter(ostream *out, double width, double height, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, StringReference *errorMessages){
+    PNGStreamWriter *writer;
+    vector<unsigned char> *header;
+    size_t chunkStart;
+
+    if(!PNGFilterTypeValid(filterType, errorMessages)){
+        return NULL;
+    }
+
+    writer = new PNGStreamWriter();
+    writer->out = out;
+    writer->width = width;
+    writer->height = height;
+    writer->colorType = colorType;
+    writer->bytesPerPixel = colorType == 6.0 ? 4 : 1;
+    writer->filterType = filterType;
+    writer->dynamic = compressionLevel > 10.0;
+    writer->level = writer->dynamic ? compressionLevel - 10.0 : compressionLevel;
+    writer->rowsWritten = 0;
+    writer->adler = 1;
+    writer->raw = new vector<unsigned char> (writer->width*writer->bytesPerPixel);
+    writer->previous = new vector<unsigned char> (writer->width*writer->bytesPerPixel, 0);
+    writer->window = new vector<unsigned char> ();
+    writer->windowStart = 0;
+    writer->deflate = CreateDeflateBitWriter(PNG_STREAM_BLOCK_SIZE);
+    writer->idat = new vector<unsigned char> ();
+    writer->idat->reserve(PNG_STREAM_IDAT_SIZE);
+
+    /* zlib header, the same CMF and FLG as ZLibCompressStaticHuffman */
+    writer->deflate->bytes->push_back(120);
+    writer->deflate->bytes->push_back(1);
+
+    header = PNGSignature();
+
+    chunkStart = PNGBeginChunk(header, "IHDR", PNGHeaderLength());
+    AppendUInt32BE(header, writer->width);
+    AppendUInt32BE(header, writer->height);
+    header->push_back(8);
+    header->push_back(colorType);
+    header->push_back(0);
+    header->push_back(0);
+    header->push_back(0);
+    PNGEndChunk(header, chunkStart);
+
+    if(setPhys){
+        chunkStart = PNGBeginChunk(header, "pHYs", 4 + 4 + 1);
+        AppendUInt32BE(header, pixelsPerMeter);
+        AppendUInt32BE(header, pixelsPerMeter);
+        header->push_back(1);
+        PNGEndChunk(header, chunkStart);
+    }
+
+    out->write(reinterpret_cast<char *>(header->data()), header->size());
+    delete header;
+
+    return writer;
+}
+void PNGStreamWriteRow(PNGStreamWriter *writer, RGBAPixel *pixels){
+    size_t stride, rowStart;
+
+    stride = writer->raw->size();
+
+    PNGPixelsToBytes(pixels, writer->width, writer->colorType, writer->raw->data());
+
+    rowStart = writer->window->size();
+    writer->window->resize(rowStart + 1 + stride);
+    writer->window->at(rowStart) = PNGFilterRowWithType(writer->raw->data(), writer->previous->data(), stride, writer->bytesPerPixel, writer->filterType, writer->window->data() + rowStart + 1);
+    writer->adler = UpdateAdler32(writer->adler, writer->window->data() + rowStart, 1 + stride);
+
+    writer->previous->swap(*writer->raw);
+    writer->rowsWritten++;
+
+    if(writer->window->size() - writer->windowStart >= PNG_STREAM_BLOCK_SIZE){
+        PNGStreamCompressPending(writer, false);
+    }
+}
+void PNGStreamWriteImage(PNGStreamWriter *writer, RGBABitmapImage *image){
+    size_t y;
+
+    for(y = 0; y < image->height; y++){
+        PNGStreamWriteRow(writer, ImagePixelAt(image, 0.0, y));
+    }
+}
+void PNGStreamCompressPending(PNGStreamWriter *writer, bool final){
+    vector<DeflateToken> *tokens;
+    size_t keep;
+
+    tokens = DeflateTokenize(writer->window, writer->windowStart, writer->level);
+    WriteDeflateBlocks(writer->deflate, tokens, final, writer->dynamic);
+    delete tokens;
+
+    /* Keep the last 32 KiB as history for the matches of the next block. */
+    keep = min(writer->window->size(), (size_t)DEFLATE_WINDOW_SIZE);
+    writer->window->erase(writer->window->begin(), writer->window->end() - keep);
+    writer->windowStart = writer->window->size();
+
+    PNGStreamFlushIDAT(writer, false);
+}
+void PNGStreamFlushIDAT(PNGStreamWriter *writer, bool all){
+    vector<unsigned char> *compressed;
+    size_t next, length, chunkStart;
+
+    compressed = writer->deflate->bytes;
+
+    for(next = 0; next < compressed->size() && (all || compressed->size() - next >= PNG_STREAM_IDAT_SIZE); next = next + length){
+        length = min(compressed->size() - next, (size_t)PNG_STREAM_IDAT_SIZE);
+
+        writer->idat->clear();
+        chunkStart = PNGBeginChunk(writer->idat, "IDAT", length);
+        writer->idat->insert(writer->idat->end(), compressed->begin() + next, compressed->begin() + next + length);
+        PNGEndChunk(writer->idat, chunkStart);
+
+        writer->out->write(reinterpret_cast<char *>(writer->idat->data()), writer->idat->size());
+    }
+
+    compressed->erase(compressed->begin(), compressed->begin() + next);
+}
+bool FinishPNGStreamWriter(PNGStreamWriter *writer){
+    vector<unsigned char> iend;
+    size_t chunkStart;
+    bool success;
 
-    length = png->signature->size() + 12.0 + PNGHeaderLength() + 12.0 + PNGIDATLength(png) + 12.0;
+    success = writer->rowsWritten == writer->height;
+
+    PNGStreamCompressPending(writer, true);
+    DeflateFlushBits(writer->deflate);
+    AppendUInt32BE(writer->deflate->bytes, writer->adler);
+    PNGStreamFlushIDAT(writer, true);
+
+    chunkStart = PNGBeginChunk(&iend, "IEND", 0);
+    PNGEndChunk(&iend, chunkStart);
+    writer->out->write(reinterpret_cast<char *>(iend.data()), iend.size());
+    writer->out->flush();
+
+    success = success && writer->out->good();
+
+    delete writer->raw;
+    delete writer->previous;
+    delete writer->window;
+    delete writer->idat;
+    FreeDeflateBitWriter(writer->deflate);
+    delete writer;
+
+    return success;
+}
+bool ConvertToPNGStream(RGBABitmapImage *image, ostream *out, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, StringReference *errorMessages){
+    PNGStreamWriter *writer;
+
+    writer = CreatePNGStreamWriter(out, ImageWidth(image), ImageHeight(image), colorType, setPhys, pixelsPerMeter, compressionLevel, filterType, errorMessages);
+    if(writer == NULL){
+        return false;
+    }
+    PNGStreamWriteImage(writer, image);
+
+    return FinishPNGStreamWriter(writer);
+}
+vector<unsigned char> *PNGSerializeChunks(PNGImage *png){
+    vector<unsigned char> *data;
+    size_t length, chunkStart;
+
+    length = png->signature->size() + 12 + PNGHeaderLength() + 12 + PNGIDATLength(png) + 12;
     if(png->physPresent){
-        length = length + 4.0 + 4.0 + 1.0 + 12.0;
+        length = length + 4 + 4 + 1 + 12;
     }
-    data = new vector<double> (length);
-    position = CreateNumberReference(0.0);
+    data = new vector<unsigned char> ();
+    data->reserve(length);
 
     /* Signature */
-    for(i = 0.0; i < png->signature->size(); i = i + 1.0){
-        WriteByte(data, png->signature->at(i), position);
-    }
+    data->insert(data->end(), png->signature->begin(), png->signature->end());
 
     /* Header */
-    chunkLength = PNGHeaderLength();
-    Write4BytesBE(data, chunkLength, position);
-    WriteStringBytes(data, toVector(L"IHDR"), position);
-    Write4BytesBE(data, png->ihdr->Width, position);
-    Write4BytesBE(data, png->ihdr->Height, position);
-    WriteByte(data, png->ihdr->BitDepth, position);
-    WriteByte(data, png->ihdr->ColourType, position);
-    WriteByte(data, png->ihdr->CompressionMethod, position);
-    WriteByte(data, png->ihdr->FilterMethod, position);
-    WriteByte(data, png->ihdr->InterlaceMethod, position);
-    Write4BytesBE(data, CRC32OfInterval(data, position->numberValue - chunkLength - 4.0, chunkLength + 4.0), position);
+    chunkStart = PNGBeginChunk(data, "IHDR", PNGHeaderLength());
+    AppendUInt32BE(data, png->ihdr->Width);
+    AppendUInt32BE(data, png->ihdr->Height);
+    data->push_back(png->ihdr->BitDepth);
+    data->push_back(png->ihdr->ColourType);
+    data->push_back(png->ihdr->CompressionMethod);
+    data->push_back(png->ihdr->FilterMethod);
+    data->push_back(png->ihdr->InterlaceMethod);
+    PNGEndChunk(data, chunkStart);
 
     /* pHYs */
     if(png->physPresent){
-        chunkLength = 4.0 + 4.0 + 1.0;
-        Write4BytesBE(data, chunkLength, position);
-        WriteStringBytes(data, toVector(L"pHYs"), position);
-
-        Write4BytesBE(data, png->phys->pixelsPerMeter, position);
-        Write4BytesBE(data, png->phys->pixelsPerMeter, position);
-        WriteByte(data, 1.0, position);
+        chunkStart = PNGBeginChunk(data, "pHYs", 4 + 4 + 1);
+        AppendUInt32BE(data, png->phys->pixelsPerMeter);
+        AppendUInt32BE(data, png->phys->pixelsPerMeter);
+        data->push_back(1);
         /* 1 = pixels per meter */
-        Write4BytesBE(data, CRC32OfInterval(data, position->numberValue - chunkLength - 4.0, chunkLength + 4.0), position);
+        PNGEndChunk(data, chunkStart);
     }
 
     /* IDAT */
-    chunkLength = PNGIDATLength(png);
-    Write4BytesBE(data, chunkLength, position);
-    WriteStringBytes(data, toVector(L"IDAT"), position);
-    WriteByte(data, png->zlibStruct->CMF, position);
-    WriteByte(data, png->zlibStruct->FLG, position);
-    for(i = 0.0; i < png->zlibStruct->CompressedDataBlocks->size(); i = i + 1.0){
-        WriteByte(data, png->zlibStruct->CompressedDataBlocks->at(i), position);
-    }
-    Write4BytesBE(data, png->zlibStruct->Adler32CheckValue, position);
-    Write4BytesBE(data, CRC32OfInterval(data, position->numberValue - chunkLength - 4.0, chunkLength + 4.0), position);
+    chunkStart = PNGBeginChunk(data, "IDAT", PNGIDATLength(png));
+    data->push_back(png->zlibStruct->CMF);
+    data->push_back(png->zlibStruct->FLG);
+    data->insert(data->end(), png->zlibStruct->CompressedDataBlocks->begin(), png->zlibStruct->CompressedDataBlocks->end());
+    AppendUInt32BE(data, png->zlibStruct->Adler32CheckValue);
+    PNGEndChunk(data, chunkStart);
 
     /* IEND */
-    chunkLength = 0.0;
-    Write4BytesBE(data, chunkLength, position);
-    WriteStringBytes(data, toVector(L"IEND"), position);
-    Write4BytesBE(data, CRC32OfInterval(data, position->numberValue - 4.0, 4.0), position);
+    chunkStart = PNGBeginChunk(data, "IEND", 0);
+    PNGEndChunk(data, chunkStart);
 
     return data;
 }
+void AppendUInt32BE(vector<unsigned char> *data, unsigned int value){
+    data->push_back(value >> 24);
+    data->push_back(value >> 16);
+    data->push_back(value >> 8);
+    data->push_back(value);
+}
+size_t PNGBeginChunk(vector<unsigned char> *data, const char *type, size_t length){
+    size_t chunkStart;
+
+    AppendUInt32BE(data, length);
+    chunkStart = data->size();
+    data->insert(data->end(), type, type + 4);
+
+    return chunkStart;
+}
+void PNGEndChunk(vector<unsigned char> *data, size_t chunkStart){
+    /* The CRC covers the chunk type and data, computed in place. */
+    AppendUInt32BE(data, CRC32OfBytes(data->data() + chunkStart, data->size() - chunkStart));
+}
 double PNGIDATLength(PNGImage *png){
     return 2.0 + png->zlibStruct->CompressedDataBlocks->size() + 4.0;
 }
 double PNGHeaderLength(){
     return 4.0 + 4.0 + 1.0 + 1.0 + 1.0 + 1.0 + 1.0;
 }
-vector<double> *GetPNGColorData(RGBABitmapImage *image){
-    vector<double> *colordata;
-    double length, x, y, next;
-    RGBA *rgba;
+vector<unsigned char> *GetPNGColorData(RGBABitmapImage *image){
+    vector<unsigned char> *colordata;
+    size_t y, stride;
 
-    length = 4.0*ImageWidth(image)*ImageHeight(image) + ImageHeight(image);
+    stride = 4*image->width + 1;
+    colordata = new vector<unsigned char> (stride*image->height);
+
+    for(y = 0; y < image->height; y++){
+        colordata->at(y*stride) = 0;
+        PNGPixelsToBytes(ImagePixelAt(image, 0.0, y), image->width, 6.0, colordata->data() + y*stride + 1);
+    }
 
-    colordata = new vector<double> (length);
+    return colordata;
+}
+vector<unsigned char> *GetPNGColorDataGreyscale(RGBABitmapImage *image){
+    vector<unsigned char> *colordata;
+    size_t y, stride;
 
-    next = 0.0;
+    stride = image->width + 1;
+    colordata = new vector<unsigned char> (stride*image->height);
 
-    for(y = 0.0; y < ImageHeight(image); y = y + 1.0){
-        colordata->at(next) = 0.0;
-        next = next + 1.0;
-        for(x = 0.0; x < ImageWidth(image); x = x + 1.0){
-            rgba = image->x->at(x)->y->at(y);
-            colordata->at(next) = Round(rgba->r*255.0);
-            next = next + 1.0;
-            colordata->at(next) = Round(rgba->g*255.0);
-            next = next + 1.0;
-            colordata->at(next) = Round(rgba->b*255.0);
-            next = next + 1.0;
-            colordata->at(next) = Round(rgba->a*255.0);
-            next = next + 1.0;
-        }
+    for(y = 0; y < image->height; y++){
+        colordata->at(y*stride) = 0;
+        PNGPixelsToBytes(ImagePixelAt(image, 0.0, y), image->width, 0.0, colordata->data() + y*stride + 1);
     }
 
     return colordata;
 }
-vector<double> *GetPNGColorDataGreyscale(RGBABitmapImage *image){
-    vector<double> *colordata;
-    double length, x, y, next;
-    RGBA *rgba;
+void PNGPixelsToBytes(RGBAPixel *pixels, size_t width, double colorType, unsigned char *out){
+    size_t x;
+
+    for(x = 0; x < width; x++){
+        if(colorType == 6.0){
+            out[4*x] = Round(pixels[x].r*255.0);
+            out[4*x + 1] = Round(pixels[x].g*255.0);
+            out[4*x + 2] = Round(pixels[x].b*255.0);
+            out[4*x + 3] = Round(pixels[x].a*255.0);
+        }else{
+            out[x] = Round(pixels[x].r*255.0);
+        }
+    }
+}
+int PNGPaethPredictor(int a, int b, int c){
+    int p, pa, pb, pc, predictor;
 
-    length = ImageWidth(image)*ImageHeight(image) + ImageHeight(image);
+    p = a + b - c;
+    pa = abs(p - a);
+    pb = abs(p - b);
+    pc = abs(p - c);
 
-    colordata = new vector<double> (length);
+    if(pa <= pb && pa <= pc){
+        predictor = a;
+    }else if(pb <= pc){
+        predictor = b;
+    }else{
+        predictor = c;
+    }
 
-    next = 0.0;
+    return predictor;
+}
+void PNGFilterRow(int filterType, unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel, unsigned char *out){
+    size_t i;
+    int a, b, c, predictor;
 
-    for(y = 0.0; y < ImageHeight(image); y = y + 1.0){
-        colordata->at(next) = 0.0;
-        next = next + 1.0;
-        for(x = 0.0; x < ImageWidth(image); x = x + 1.0){
-            rgba = image->x->at(x)->y->at(y);
-            colordata->at(next) = Round(rgba->r*255.0);
-            next = next + 1.0;
+    for(i = 0; i < stride; i++){
+        a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+        b = previous[i];
+        c = i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+
+        if(filterType == PNG_FILTER_SUB){
+            predictor = a;
+        }else if(filterType == PNG_FILTER_UP){
+            predictor = b;
+        }else if(filterType == PNG_FILTER_AVERAGE){
+            predictor = (a + b)/2;
+        }else if(filterType == PNG_FILTER_PAETH){
+            predictor = PNGPaethPredictor(a, b, c);
+        }else{
+            predictor = 0;
         }
+
+        out[i] = row[i] - predictor;
+    }
+}
+size_t PNGFilterCost(unsigned char *filtered, size_t stride){
+    size_t i, cost;
+
+    /* Minimum sum of absolute differences: residuals are taken as signed bytes. */
+    cost = 0;
+    for(i = 0; i < stride; i++){
+        cost = cost + abs((signed char)filtered[i]);
     }
 
-    return colordata;
+    return cost;
+}
+void PNGFilterScanlines(vector<unsigned char> *colorData, double width, double height, double bytesPerPixel, double filterType){
+    vector<unsigned char> filtered, zeros;
+    unsigned char *row, *previous;
+    size_t stride, y;
+
+    stride = width*bytesPerPixel;
+
+    filtered.resize(stride);
+    zeros.assign(stride, 0);
+
+    /* Rows are filtered in place from the bottom up, so the row above is still unfiltered
+       when it is used as the prediction for the current one. Every row is preceded by
+       its filter type byte. */
+    for(y = height; y-- > 0; ){
+        row = colorData->data() + y*(stride + 1) + 1;
+        previous = y > 0 ? row - (stride + 1) : zeros.data();
+
+        row[-1] = PNGFilterRowWithType(row, previous, stride, bytesPerPixel, filterType, filtered.data());
+        copy(filtered.begin(), filtered.end(), row);
+    }
+}
+bool PNGFilterTypeValid(double filterType, StringReference *errorMessages){
+    bool valid;
+
+    /* PNG_FILTER_NONE to PNG_FILTER_PAETH are the filter type bytes of the format, PNG_FILTER_ADAPTIVE chooses among them */
+    valid = filterType >= PNG_FILTER_NONE && filterType <= PNG_FILTER_ADAPTIVE && filterType == floor(filterType);
+    if(!valid){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Filter type not supported."));
+    }
+
+    return valid;
+}
+int PNGFilterRowWithType(unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel, double filterType, unsigned char *out){
+    size_t cost, bestCost;
+    int type, bestType;
+
+    if(filterType == PNG_FILTER_ADAPTIVE){
+        bestType = PNG_FILTER_NONE;
+        bestCost = PNGFilterCost(row, stride);
+        for(type = PNG_FILTER_SUB; type <= PNG_FILTER_PAETH; type++){
+            PNGFilterRow(type, row, previous, stride, bytesPerPixel, out);
+            cost = PNGFilterCost(out, stride);
+            if(cost < bestCost){
+                bestType = type;
+                bestCost = cost;
+            }
+        }
+    }else{
+        bestType = filterType;
+    }
+
+    PNGFilterRow(bestType, row, previous, stride, bytesPerPixel, out);
+
+    return bestType;
 }
 IHDR *PNGHeader(RGBABitmapImage *image, double colortype){
     IHDR *ihdr;
@@ -4343,18 +4657,18 @@ IHDR *PNGHeader(RGBABitmapImage *image, double colortype){
     /* no interlace */
     return ihdr;
 }
-vector<double> *PNGSignature(){
-    vector<double> *s;
+vector<unsigned char> *PNGSignature(){
+    vector<unsigned char> *s;
 
-    s = new vector<double> (8.0);
-    s->at(0) = 137.0;
-    s->at(1) = 80.0;
-    s->at(2) = 78.0;
-    s->at(3) = 71.0;
-    s->at(4) = 13.0;
-    s->at(5) = 10.0;
-    s->at(6) = 26.0;
-    s->at(7) = 10.0;
+    s = new vector<unsigned char> (8);
+    s->at(0) = 137;
+    s->at(1) = 80;
+    s->at(2) = 78;
+    s->at(3) = 71;
+    s->at(4) = 13;
+    s->at(5) = 10;
+    s->at(6) = 26;
+    s->at(7) = 10;
 
     return s;
 }
@@ -4411,7 +4725,9 @@ bool PNGReadHeader(RGBABitmapImage *image, vector<Chunk*> *cs, StringReference *
             ihdr->InterlaceMethod = ReadByte(c->data, position);
 
             n = CreateImage(ihdr->Width, ihdr->Height, GetTransparent());
-            image->x = n->x;
+            image->width = n->width;
+            image->height = n->height;
+            image->pixels = n->pixels;
 
             if(ihdr->ColourType == 6.0){
                 if(ihdr->BitDepth == 8.0){
@@ -4483,6 +4799,202 @@ Chunk *PNGReadChunk(vector<double> *data, NumberReference *position){
 
     return c;
 }
+bool ReadPNG(RGBABitmapImageReference *imageReference, vector<unsigned char> *data, StringReference *errorMessages){
+    vector<unsigned char> *signature, idat, raw;
+    const unsigned char *chunk;
+    size_t position, length, width, height, stride, bytesPerPixel, y;
+    unsigned int crc;
+    int bitDepth, colorType, interlace;
+    bool success, header, end;
+
+    success = true;
+    header = false;
+    end = false;
+    width = 0;
+    height = 0;
+    bitDepth = 0;
+    colorType = 0;
+    interlace = 0;
+
+    signature = PNGSignature();
+    if(data->size() < signature->size() || !equal(signature->begin(), signature->end(), data->begin())){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Not a PNG file."));
+        success = false;
+    }
+    position = signature->size();
+    delete signature;
+
+    /* Chunks are read in place, only the IDAT payloads are gathered. */
+    for(; success && !end; position = position + 12 + length){
+        if(position + 12 > data->size()){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Unexpected end of PNG data."));
+            success = false;
+            break;
+        }
+        chunk = data->data() + position;
+        length = (size_t)chunk[0] << 24 | (size_t)chunk[1] << 16 | (size_t)chunk[2] << 8 | chunk[3];
+        if(length > data->size() - position - 12){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Chunk length out of range."));
+            success = false;
+            break;
+        }
+        crc = (unsigned int)chunk[8 + length] << 24 | (unsigned int)chunk[9 + length] << 16 | (unsigned int)chunk[10 + length] << 8 | chunk[11 + length];
+        if(CRC32OfBytes(chunk + 4, 4 + length) != crc){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Chunk CRC mismatch."));
+            success = false;
+            break;
+        }
+
+        if(memcmp(chunk + 4, "IHDR", 4) == 0 && length == 13){
+            width = (size_t)chunk[8] << 24 | (size_t)chunk[9] << 16 | (size_t)chunk[10] << 8 | chunk[11];
+            height = (size_t)chunk[12] << 24 | (size_t)chunk[13] << 16 | (size_t)chunk[14] << 8 | chunk[15];
+            bitDepth = chunk[16];
+            colorType = chunk[17];
+            interlace = chunk[20];
+            header = chunk[18] == 0 && chunk[19] == 0;
+        }else if(memcmp(chunk + 4, "IDAT", 4) == 0){
+            idat.insert(idat.end(), chunk + 8, chunk + 8 + length);
+        }else if(memcmp(chunk + 4, "IEND", 4) == 0){
+            end = true;
+        }
+    }
+
+    if(success && !header){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Missing or unsupported IHDR chunk."));
+        success = false;
+    }
+    if(success && bitDepth != 8){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Bit depth not supported."));
+        success = false;
+    }
+    if(success && interlace != 0){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Interlace method not supported."));
+        success = false;
+    }
+
+    bytesPerPixel = 0;
+    if(colorType == 0){
+        bytesPerPixel = 1;
+    }else if(colorType == 2){
+        bytesPerPixel = 3;
+    }else if(colorType == 4){
+        bytesPerPixel = 2;
+    }else if(colorType == 6){
+        bytesPerPixel = 4;
+    }else if(success){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Color type not supported."));
+        success = false;
+    }
+    if(success && (width == 0 || height == 0 || width > PNG_MAX_DIMENSION || height > PNG_MAX_DIMENSION)){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Image dimensions out of range."));
+        success = false;
+    }
+    stride = width*bytesPerPixel;
+    if(success && stride + 1 > SIZE_MAX/height){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Image too large."));
+        success = false;
+    }
+
+    if(success){
+        /* The header alone does not justify the allocation, the compressed data has to be able to fill it. */
+        raw.reserve(min((stride + 1)*height, idat.size()*INFLATE_MAX_RATIO));
+        success = ZLibUncompress(idat.data(), idat.size(), &raw, errorMessages);
+    }
+    if(success && raw.size() != (stride + 1)*height){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Image data has the wrong size."));
+        success = false;
+    }
+
+    if(success){
+        if(imageReference->image != NULL){
+            DeleteImage(imageReference->image);
+        }
+        imageReference->image = CreateImage(width, height, GetTransparent());
+        for(y = 0; y < height && success; y++){
+            success = PNGUnfilterRow(raw.at(y*(stride + 1)), raw.data() + y*(stride + 1) + 1, y > 0 ? raw.data() + (y - 1)*(stride + 1) + 1 : NULL, stride, bytesPerPixel);
+            PNGBytesToPixels(raw.data() + y*(stride + 1) + 1, width, colorType, ImagePixelAt(imageReference->image, 0.0, y));
+        }
+        if(!success){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid filter type."));
+            DeleteImage(imageReference->image);
+            imageReference->image = NULL;
+        }
+    }
+
+    return success;
+}
+bool PNGUnfilterRow(int type, unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel){
+    size_t i;
+    int a, b, c;
+
+    /* The first row has an implicit all-zero row above it. */
+    if(previous == NULL){
+        if(type == PNG_FILTER_UP){
+            return true;
+        }else if(type == PNG_FILTER_AVERAGE){
+            for(i = bytesPerPixel; i < stride; i++){
+                row[i] = row[i] + (row[i - bytesPerPixel] >> 1);
+            }
+            return true;
+        }else if(type == PNG_FILTER_PAETH){
+            type = PNG_FILTER_SUB;
+        }
+    }
+
+    if(type == PNG_FILTER_NONE){
+    }else if(type == PNG_FILTER_SUB){
+        for(i = bytesPerPixel; i < stride; i++){
+            row[i] = row[i] + row[i - bytesPerPixel];
+        }
+    }else if(type == PNG_FILTER_UP){
+        for(i = 0; i < stride; i++){
+            row[i] = row[i] + previous[i];
+        }
+    }else if(type == PNG_FILTER_AVERAGE){
+        for(i = 0; i < stride; i++){
+            a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+            row[i] = row[i] + ((a + previous[i]) >> 1);
+        }
+    }else if(type == PNG_FILTER_PAETH){
+        for(i = 0; i < stride; i++){
+            a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+            b = previous[i];
+            c = i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+            row[i] = row[i] + PNGPaethPredictor(a, b, c);
+        }
+    }else{
+        return false;
+    }
+
+    return true;
+}
+void PNGBytesToPixels(unsigned char *bytes, size_t width, int colorType, RGBAPixel *pixels){
+    size_t x;
+
+    for(x = 0; x < width; x++){
+        if(colorType == 6){
+            pixels[x].r = bytes[4*x]/255.0;
+            pixels[x].g = bytes[4*x + 1]/255.0;
+            pixels[x].b = bytes[4*x + 2]/255.0;
+            pixels[x].a = bytes[4*x + 3]/255.0;
+        }else if(colorType == 2){
+            pixels[x].r = bytes[3*x]/255.0;
+            pixels[x].g = bytes[3*x + 1]/255.0;
+            pixels[x].b = bytes[3*x + 2]/255.0;
+            pixels[x].a = 1.0;
+        }else if(colorType == 4){
+            pixels[x].r = bytes[2*x]/255.0;
+            pixels[x].g = pixels[x].r;
+            pixels[x].b = pixels[x].r;
+            pixels[x].a = bytes[2*x + 1]/255.0;
+        }else{
+            pixels[x].r = bytes[x]/255.0;
+            pixels[x].g = pixels[x].r;
+            pixels[x].b = pixels[x].r;
+            pixels[x].a = 1.0;
+        }
+    }
+}
 void WriteStringToStingStream(vector<wchar_t> *stream, NumberReference *index, vector<wchar_t> *src){
     double i;
 
@@ -4978,33 +5490,210 @@ double UpdateCRC32(double crc, vector<double> *buf, vector<double> *crc_table){
     return crc;
 }
 double CalculateCRC32(vector<double> *buf){
-    vector<double> *crcTable;
-    double b32max, value;
+    return CRC32OfInterval(buf, 0.0, buf->size());
+}
+double CRC32OfInterval(vector<double> *data, double from, double length){
+    unsigned char chunk[256];
+    unsigned int crc;
+    size_t start, end, n, i;
 
-    crcTable = MakeCRC32Table();
+    /* The bytes are narrowed in small stack chunks, no copy of the interval is made. */
+    crc = 0xFFFFFFFFu;
+    start = from;
+    end = from + length;
+    for(; start < end; start = start + n){
+        n = min(end - start, sizeof(chunk));
+        for(i = 0; i < n; i++){
+            chunk[i] = data->at(start + i);
+        }
+        crc = UpdateCRC32Bytes(crc, chunk, n);
+    }
 
-    b32max = pow(2.0, 32.0) - 1.0;
-    value = UpdateCRC32(b32max, buf, crcTable);
+    return crc ^ 0xFFFFFFFFu;
+}
+unsigned int CRC32OfBytes(const unsigned char *data, size_t length){
+    return UpdateCRC32Bytes(0xFFFFFFFFu, data, length) ^ 0xFFFFFFFFu;
+}
+const unsigned int *CRC32SliceTables(){
+    static const vector<unsigned int> *tables = BuildCRC32SliceTables();
 
-    return Xor4Byte(value, b32max);
+    return tables->data();
 }
-double CRC32OfInterval(vector<double> *data, double from, double length){
-    vector<double> *crcBase;
-    double i, crc;
+vector<unsigned int> *BuildCRC32SliceTables(){
+    vector<unsigned int> *tables;
+    unsigned int c;
+    size_t n, k;
 
-    crcBase = new vector<double> (length);
+    tables = new vector<unsigned int> (8*256);
 
-    for(i = 0.0; i < length; i = i + 1.0){
-        crcBase->at(i) = data->at(from + i);
+    for(n = 0; n < 256; n++){
+        c = n;
+        for(k = 0; k < 8; k++){
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        tables->at(n) = c;
+    }
+    /* Table k advances a byte through k further zero bytes. */
+    for(n = 0; n < 256; n++){
+        for(k = 1; k < 8; k++){
+            c = tables->at((k - 1)*256 + n);
+            tables->at(k*256 + n) = tables->at(c & 0xFF) ^ (c >> 8);
+        }
     }
 
-    crc = CalculateCRC32(crcBase);
+    return tables;
+}
+unsigned int UpdateCRC32Slice8(unsigned int crc, const unsigned char *data, size_t length){
+    const unsigned int *t;
+    unsigned int one, two;
+
+    t = CRC32SliceTables();
+
+    for(; length >= 8; length = length - 8){
+        one = crc ^ ((unsigned int)data[0] | (unsigned int)data[1] << 8 | (unsigned int)data[2] << 16 | (unsigned int)data[3] << 24);
+        two = (unsigned int)data[4] | (unsigned int)data[5] << 8 | (unsigned int)data[6] << 16 | (unsigned int)data[7] << 24;
+        crc = t[7*256 + (one & 0xFF)] ^ t[6*256 + ((one >> 8) & 0xFF)] ^ t[5*256 + ((one >> 16) & 0xFF)] ^ t[4*256 + (one >> 24)]
+            ^ t[3*256 + (two & 0xFF)] ^ t[2*256 + ((two >> 8) & 0xFF)] ^ t[1*256 + ((two >> 16) & 0xFF)] ^ t[two >> 24];
+        data = data + 8;
+    }
+    for(; length > 0; length--){
+        crc = t[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        data++;
+    }
 
-    delete crcBase;
+    return crc;
+}
+#if defined(PBPLOTS_X86_SIMD)
+/* Carry-less multiplication folding, after Gopal et al., "Fast CRC Computation for Generic
+   Polynomials Using PCLMULQDQ Instruction". Needs length >= 64 and a multiple of 16. */
+__attribute__((target("pclmul,sse4.1")))
+unsigned int UpdateCRC32Clmul(unsigned int crc, const unsigned char *data, size_t length){
+    alignas(16) static const unsigned long long k1k2[2] = {0x0154442bd4ull, 0x01c6e41596ull};
+    alignas(16) static const unsigned long long k3k4[2] = {0x01751997d0ull, 0x00ccaa009eull};
+    alignas(16) static const unsigned long long k5k0[2] = {0x0163cd6124ull, 0x0000000000ull};
+    alignas(16) static const unsigned long long poly[2] = {0x01db710641ull, 0x01f7011641ull};
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(data + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(data + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(data + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0 = _mm_load_si128((const __m128i *)k1k2);
+    data = data + 64;
+    length = length - 64;
+
+    /* Fold four 128 bit lanes in parallel. */
+    for(; length >= 64; length = length - 64){
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        y5 = _mm_loadu_si128((const __m128i *)(data + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *)(data + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *)(data + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *)(data + 0x30));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+        data = data + 64;
+    }
+
+    /* Fold the lanes into one. */
+    x0 = _mm_load_si128((const __m128i *)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    for(; length >= 16; length = length - 16){
+        x2 = _mm_loadu_si128((const __m128i *)data);
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        data = data + 16;
+    }
+
+    /* Fold 128 bits to 64, then Barrett reduce to 32. */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_load_si128((const __m128i *)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return _mm_extract_epi32(x1, 1);
+}
+#elif defined(PBPLOTS_ARM_SIMD)
+__attribute__((target("+crc")))
+unsigned int UpdateCRC32Clmul(unsigned int crc, const unsigned char *data, size_t length){
+    unsigned long long word;
+
+    /* The ARMv8 CRC32 instructions use the same reflected polynomial as PNG. */
+    for(; length >= 8; length = length - 8){
+        memcpy(&word, data, 8);
+        crc = __crc32d(crc, word);
+        data = data + 8;
+    }
+    for(; length > 0; length--){
+        crc = __crc32b(crc, *data);
+        data++;
+    }
 
     return crc;
 }
-ZLIBStruct *ZLibCompressNoCompression(vector<double> *data){
+#endif
+bool CRC32HardwareAvailable(){
+#if defined(PBPLOTS_X86_SIMD)
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#elif defined(PBPLOTS_ARM_SIMD) && defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#else
+    return false;
+#endif
+}
+unsigned int UpdateCRC32Bytes(unsigned int crc, const unsigned char *data, size_t length){
+    static const bool hardware = CRC32HardwareAvailable();
+
+#if defined(PBPLOTS_X86_SIMD)
+    size_t folded;
+
+    if(hardware && length >= 64){
+        folded = length & ~(size_t)15;
+        crc = UpdateCRC32Clmul(crc, data, folded);
+        data = data + folded;
+        length = length - folded;
+    }
+#elif defined(PBPLOTS_ARM_SIMD)
+    if(hardware){
+        return UpdateCRC32Clmul(crc, data, length);
+    }
+#else
+    (void)hardware;
+#endif
+
+    return UpdateCRC32Slice8(crc, data, length);
+}
+ZLIBStruct *ZLibCompressNoCompression(vector<unsigned char> *data){
     ZLIBStruct *zlibStruct;
 
     zlibStruct = new ZLIBStruct();
@@ -5012,44 +5701,141 @@ ZLIBStruct *ZLibCompressNoCompression(vector<double> *data){
     zlibStruct->CMF = 120.0;
     zlibStruct->FLG = 1.0;
     zlibStruct->CompressedDataBlocks = DeflateDataNoCompression(data);
-    zlibStruct->Adler32CheckValue = ComputeAdler32(data);
+    zlibStruct->Adler32CheckValue = Adler32OfBytes(data->data(), data->size());
 
     return zlibStruct;
 }
-ZLIBStruct *ZLibCompressStaticHuffman(vector<double> *data, double level){
+ZLIBStruct *ZLibCompressDynamicHuffman(vector<unsigned char> *data, double level){
     ZLIBStruct *zlibStruct;
 
     zlibStruct = new ZLIBStruct();
 
     zlibStruct->CMF = 120.0;
     zlibStruct->FLG = 1.0;
-    zlibStruct->CompressedDataBlocks = DeflateDataStaticHuffman(data, level);
-    zlibStruct->Adler32CheckValue = ComputeAdler32(data);
+    zlibStruct->CompressedDataBlocks = DeflateDataDynamicHuffman(data, level);
+    zlibStruct->Adler32CheckValue = Adler32OfBytes(data->data(), data->size());
 
     return zlibStruct;
 }
-vector<double> *AddNumber(vector<double> *list, double a){
-    vector<double> *newlist;
-    double i;
+ZLIBStruct *ZLibCompressParallel(vector<unsigned char> *data, double level, bool dynamic, double threads){
+    ZLIBStruct *zlibStruct;
+    vector<vector<unsigned char> *> segments;
+    vector<thread> workers;
+    atomic<size_t> next;
+    size_t count, workerCount, i;
 
-    newlist = new vector<double> (list->size() + 1.0);
-    for(i = 0.0; i < list->size(); i = i + 1.0){
-        newlist->at(i) = list->at(i);
-    }
-    newlist->at(list->size()) = a;
+    zlibStruct = new ZLIBStruct();
 
-    delete list;
+    zlibStruct->CMF = 120.0;
+    zlibStruct->FLG = 1.0;
 
-    return newlist;
-}
-void AddNumberRef(NumberArrayReference *list, double i){
-    list->numberArray = AddNumber(list->numberArray, i);
-}
-vector<double> *RemoveNumber(vector<double> *list, double n){
-    vector<double> *newlist;
-    double i;
+    count = max((size_t)1, (data->size() + DEFLATE_PARALLEL_SEGMENT_SIZE - 1)/DEFLATE_PARALLEL_SEGMENT_SIZE);
+    segments.assign(count, NULL);
 
-    newlist = new vector<double> (list->size() - 1.0);
+    /* threads <= 0 means every hardware thread. Positive counts are rounded down, but never
+       below one worker, and are clamped to the segment count before the cast. */
+    if(threads > 0.0){
+        workerCount = (size_t)fmax(1.0, fmin(floor(threads), (double)count));
+    }else{
+        workerCount = max(1u, thread::hardware_concurrency());
+    }
+    workerCount = min(workerCount, count);
+
+    /* Workers take segments in order from a shared counter until none are left. */
+    next = 0;
+    for(i = 0; i < workerCount; i++){
+        workers.push_back(thread([&](){
+            size_t segment;
+
+            for(segment = next++; segment < count; segment = next++){
+                segments.at(segment) = DeflateSegment(data, segment*DEFLATE_PARALLEL_SEGMENT_SIZE, min((segment + 1)*DEFLATE_PARALLEL_SEGMENT_SIZE, data->size()), level, dynamic, segment + 1 == count);
+            }
+        }));
+    }
+    for(i = 0; i < workerCount; i++){
+        workers.at(i).join();
+    }
+
+    zlibStruct->CompressedDataBlocks = new vector<unsigned char> ();
+    for(i = 0; i < count; i++){
+        zlibStruct->CompressedDataBlocks->insert(zlibStruct->CompressedDataBlocks->end(), segments.at(i)->begin(), segments.at(i)->end());
+        delete segments.at(i);
+    }
+    zlibStruct->Adler32CheckValue = Adler32OfBytes(data->data(), data->size());
+
+    return zlibStruct;
+}
+vector<unsigned char> *DeflateSegment(vector<unsigned char> *data, size_t start, size_t end, double level, bool dynamic, bool final){
+    vector<unsigned char> window;
+    vector<DeflateToken> *tokens;
+    DeflateBitWriter *writer;
+    vector<unsigned char> *bytes;
+    size_t history;
+
+    /* The segment is primed with up to 32 KiB of the data before it, so matches may
+       reach back across the segment boundary like in a single stream. */
+    history = min(start, (size_t)DEFLATE_WINDOW_SIZE);
+    window.assign(data->begin() + start - history, data->begin() + end);
+
+    tokens = DeflateTokenize(&window, history, level);
+    writer = CreateDeflateBitWriter((end - start)/2 + 64);
+
+    WriteDeflateBlocks(writer, tokens, final, dynamic);
+    if(!final){
+        DeflateWriteSyncFlush(writer);
+    }
+    DeflateFlushBits(writer);
+
+    bytes = writer->bytes;
+    delete writer;
+    delete tokens;
+
+    return bytes;
+}
+void DeflateWriteSyncFlush(DeflateBitWriter *writer){
+    /* An empty non-final stored block ends on a byte boundary, so the next segment can
+       be appended byte-wise. */
+    DeflateWriteBits(writer, 0, 3);
+    DeflateFlushBits(writer);
+    writer->bytes->push_back(0x00);
+    writer->bytes->push_back(0x00);
+    writer->bytes->push_back(0xFF);
+    writer->bytes->push_back(0xFF);
+}
+ZLIBStruct *ZLibCompressStaticHuffman(vector<unsigned char> *data, double level){
+    ZLIBStruct *zlibStruct;
+
+    zlibStruct = new ZLIBStruct();
+
+    zlibStruct->CMF = 120.0;
+    zlibStruct->FLG = 1.0;
+    zlibStruct->CompressedDataBlocks = DeflateDataStaticHuffman(data, level);
+    zlibStruct->Adler32CheckValue = Adler32OfBytes(data->data(), data->size());
+
+    return zlibStruct;
+}
+vector<double> *AddNumber(vector<double> *list, double a){
+    vector<double> *newlist;
+    double i;
+
+    newlist = new vector<double> (list->size() + 1.0);
+    for(i = 0.0; i < list->size(); i = i + 1.0){
+        newlist->at(i) = list->at(i);
+    }
+    newlist->at(list->size()) = a;
+
+    delete list;
+
+    return newlist;
+}
+void AddNumberRef(NumberArrayReference *list, double i){
+    list->numberArray = AddNumber(list->numberArray, i);
+}
+vector<double> *RemoveNumber(vector<double> *list, double n){
+    vector<double> *newlist;
+    double i;
+
+    newlist = new vector<double> (list->size() - 1.0);
 
     if(n >= 0.0 && n < list->size()){
         for(i = 0.0; i < list->size(); i = i + 1.0){
@@ -6401,70 +7187,368 @@ double ComputeAdler32(vector<double> *data){
 
     return b*pow(2.0, 16.0) + a;
 }
-vector<double> *DeflateDataStaticHuffman(vector<double> *data, double level){
-    vector<double> *bytes;
-    NumberReference *currentBit;
-    double i;
-    NumberArrayReference *copy;
-    NumberReference *code, *length, *compressedCode, *lengthAdditionLength, *distanceCode;
-    NumberReference *distanceReference, *lengthReference, *lengthAddition;
-    NumberReference *distanceAdditionReference, *distanceAdditionLengthReference;
-    vector<double> *bitReverseLookupTable;
-    BooleanReference *match;
+unsigned int Adler32OfBytes(const unsigned char *data, size_t length){
+    return UpdateAdler32(1, data, length);
+}
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char *data, size_t length){
+    static const int path = Adler32SIMDPath();
 
-    code = CreateNumberReference(0.0);
-    length = CreateNumberReference(0.0);
-    compressedCode = CreateNumberReference(0.0);
-    lengthAdditionLength = CreateNumberReference(0.0);
-    distanceCode = CreateNumberReference(0.0);
-    distanceReference = CreateNumberReference(0.0);
-    lengthReference = CreateNumberReference(0.0);
-    lengthAddition = CreateNumberReference(0.0);
-    distanceAdditionReference = CreateNumberReference(0.0);
-    distanceAdditionLengthReference = CreateNumberReference(0.0);
-    match = new BooleanReference();
+    return UpdateAdler32WithPath(adler, data, length, path);
+}
+unsigned int UpdateAdler32WithPath(unsigned int adler, const unsigned char *data, size_t length, int path){
+    unsigned long long a, b;
+    size_t run, vectorized;
+
+    a = adler & 0xFFFF;
+    b = adler >> 16;
+
+    /* The sums are reduced once per ADLER32_NMAX bytes instead of once per byte. */
+    for(; length > 0; length = length - run){
+        run = min(length, (size_t)ADLER32_NMAX);
+        vectorized = 0;
+#if defined(PBPLOTS_X86_SIMD)
+        if(path == 2){
+            vectorized = Adler32BlockAVX2(data, run, &a, &b);
+        }else if(path == 1){
+            vectorized = Adler32BlockSSE2(data, run, &a, &b);
+        }
+#elif defined(PBPLOTS_ARM_SIMD)
+        if(path == 1){
+            vectorized = Adler32BlockNEON(data, run, &a, &b);
+        }
+#else
+        (void)path;
+#endif
+        Adler32BlockScalar(data + vectorized, run - vectorized, &a, &b);
+        a = a % 65521;
+        b = b % 65521;
+        data = data + run;
+    }
+
+    return (b << 16) | a;
+}
+void Adler32BlockScalar(const unsigned char *data, size_t length, unsigned long long *aReference, unsigned long long *bReference){
+    unsigned long long a, b;
+    size_t i;
+
+    a = *aReference;
+    b = *bReference;
+
+    for(i = 0; i + 4 <= length; i = i + 4){
+        a = a + data[i];
+        b = b + a;
+        a = a + data[i + 1];
+        b = b + a;
+        a = a + data[i + 2];
+        b = b + a;
+        a = a + data[i + 3];
+        b = b + a;
+    }
+    for(; i < length; i++){
+        a = a + data[i];
+        b = b + a;
+    }
+
+    *aReference = a;
+    *bReference = b;
+}
+void TestAdler32(NumberReference *failures){
+    const size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 64, 65, 1000, ADLER32_NMAX - 33, ADLER32_NMAX - 1, ADLER32_NMAX, ADLER32_NMAX + 1, ADLER32_NMAX + 31, 2*ADLER32_NMAX, 3*ADLER32_NMAX + 17, 100003};
+    vector<unsigned char> data;
+    vector<double> values;
+    unsigned int seed, expected, split;
+    size_t i, k, length, offset;
+    int fill, path;
+
+    seed = 12345;
+    for(fill = 0; fill < 2; fill++){
+        for(k = 0; k < sizeof(lengths)/sizeof(lengths[0]); k++){
+            length = lengths[k];
+
+            /* random bytes, then all 0xFF, the worst case for the deferred reduction; one byte of
+               lead-in makes the vector loads unaligned */
+            data.assign(length + 1, 0xFF);
+            if(fill == 0){
+                for(i = 0; i < data.size(); i++){
+                    seed = seed*1103515245 + 12345;
+                    data[i] = seed >> 16;
+                }
+            }
+            for(offset = 0; offset < 2; offset++){
+                values.assign(data.begin() + offset, data.begin() + offset + length);
+                expected = ComputeAdler32(&values);
 
-    bytes = new vector<double> (fmax(data->size()*2.0, 100.0));
-    aFillNumberArray(bytes, 0.0);
-    currentBit = CreateNumberReference(0.0);
+                /* every kernel this build and CPU has, down to the scalar one */
+                for(path = Adler32SIMDPath(); path >= 0; path--){
+                    AssertEquals(UpdateAdler32WithPath(1, data.data() + offset, length, path), expected, failures);
 
-    bitReverseLookupTable = GenerateBitReverseLookupTable(9.0);
+                    split = length/3;
+                    AssertEquals(UpdateAdler32WithPath(UpdateAdler32WithPath(1, data.data() + offset, split, path), data.data() + offset + split, length - split, path), expected, failures);
+                }
+            }
+        }
+    }
+}
+void TestCRC32(NumberReference *failures){
+    const size_t lengths[] = {0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 79, 80, 127, 128, 1000, 4109, 100003};
+    vector<unsigned char> data;
+    vector<double> values, *table;
+    unsigned int seed, expected, split;
+    size_t i, k, length, offset;
+    int fill;
 
-    /* Final block */
-    AppendBitsToBytesRight(bytes, currentBit, 1.0, 1.0);
-    /* Fixed code */
-    AppendBitsToBytesRight(bytes, currentBit, 1.0, 2.0);
+    table = MakeCRC32Table();
 
-    for(i = 0.0; i < data->size(); ){
-        FindMatch(data, i, distanceReference, lengthReference, match, level);
+    seed = 54321;
+    for(fill = 0; fill < 2; fill++){
+        for(k = 0; k < sizeof(lengths)/sizeof(lengths[0]); k++){
+            length = lengths[k];
 
-        if(match->booleanValue){
-            GetDeflateLengthCode(lengthReference->numberValue, compressedCode, lengthAddition, lengthAdditionLength);
-            GetDeflateDistanceCode(distanceReference->numberValue, distanceCode, distanceAdditionReference, distanceAdditionLengthReference, bitReverseLookupTable);
+            /* random bytes, then all 0xFF; one byte of lead-in makes the vector loads unaligned */
+            data.assign(length + 1, 0xFF);
+            if(fill == 0){
+                for(i = 0; i < data.size(); i++){
+                    seed = seed*1103515245 + 12345;
+                    data[i] = seed >> 16;
+                }
+            }
+            for(offset = 0; offset < 2; offset++){
+                values.assign(data.begin() + offset, data.begin() + offset + length);
+                expected = Xor4Byte(UpdateCRC32(4294967295.0, &values, table), 4294967295.0);
+
+                AssertEquals(CRC32OfBytes(data.data() + offset, length), expected, failures);
+                AssertEquals(UpdateCRC32Slice8(0xFFFFFFFFu, data.data() + offset, length) ^ 0xFFFFFFFFu, expected, failures);
+
+                split = length/3;
+                AssertEquals(UpdateCRC32Bytes(UpdateCRC32Bytes(0xFFFFFFFFu, data.data() + offset, split), data.data() + offset + split, length - split) ^ 0xFFFFFFFFu, expected, failures);
+
+#if defined(PBPLOTS_X86_SIMD)
+                /* the folding kernel takes 64 bytes or more, in whole 16 byte blocks */
+                if(CRC32HardwareAvailable() && length >= 64 && length % 16 == 0){
+                    AssertEquals(UpdateCRC32Clmul(0xFFFFFFFFu, data.data() + offset, length) ^ 0xFFFFFFFFu, expected, failures);
+                }
+#elif defined(PBPLOTS_ARM_SIMD)
+                if(CRC32HardwareAvailable()){
+                    AssertEquals(UpdateCRC32Clmul(0xFFFFFFFFu, data.data() + offset, length) ^ 0xFFFFFFFFu, expected, failures);
+                }
+#endif
+            }
         }
+    }
 
-        if( !match->booleanValue ){
-            GetDeflateStaticHuffmanCode(data->at(i), code, length, bitReverseLookupTable);
-            AppendBitsToBytesRight(bytes, currentBit, code->numberValue, length->numberValue);
-            i = i + 1.0;
+    delete table;
+}
+void TestPNGRoundTrip(NumberReference *failures){
+    const double settings[][3] = {{0.001, PNG_FILTER_ADAPTIVE, 1.0}, {1.0, PNG_FILTER_NONE, 1.0}, {5.0, PNG_FILTER_SUB, 1.0}, {10.0, PNG_FILTER_UP, 1.0}, {15.0, PNG_FILTER_AVERAGE, 1.0}, {19.0, PNG_FILTER_PAETH, 2.0}, {6.0, PNG_FILTER_ADAPTIVE, 0.0}};
+    RGBABitmapImage *image, *read;
+    RGBABitmapImageReference *imageReference;
+    StringReference *errorMessages;
+    RGBA *white;
+    vector<unsigned char> *png, bytes, out;
+    ZLIBStruct *zlibStruct;
+    RGBAPixel pixel;
+    unsigned int seed;
+    size_t x, y, k, i;
+
+    /* a smooth gradient with a few noisy rows, so every filter and match length gets used */
+    white = GetWhite();
+    image = CreateImage(131, 47, white);
+    delete white;
+    seed = 2024;
+    for(y = 0; y < image->height; y++){
+        for(x = 0; x < image->width; x++){
+            seed = seed*1103515245 + 12345;
+            pixel.r = ((x*2) % 256)/255.0;
+            pixel.g = (y % 5 == 0 ? (seed >> 16) % 256 : (y*5) % 256)/255.0;
+            pixel.b = ((x + y) % 256)/255.0;
+            pixel.a = (x % 7 == 0 ? 128 : 255)/255.0;
+            image->pixels->at(y*image->width + x) = pixel;
+        }
+    }
+
+    for(k = 0; k < sizeof(settings)/sizeof(settings[0]); k++){
+        errorMessages = CreateStringReference(toVector(L""));
+        imageReference = CreateRGBABitmapImageReference();
+        png = ConvertToPNGWithOptions(image, 6.0, false, 0.0, settings[k][0], settings[k][1], settings[k][2], errorMessages);
+
+        if(png != NULL && ReadPNG(imageReference, png, errorMessages)){
+            read = imageReference->image;
+            AssertEquals(read->width, image->width, failures);
+            AssertEquals(read->height, image->height, failures);
+            if(read->width == image->width && read->height == image->height){
+                for(i = 0; i < image->pixels->size(); i++){
+                    AssertEquals(read->pixels->at(i).r, image->pixels->at(i).r, failures);
+                    AssertEquals(read->pixels->at(i).g, image->pixels->at(i).g, failures);
+                    AssertEquals(read->pixels->at(i).b, image->pixels->at(i).b, failures);
+                    AssertEquals(read->pixels->at(i).a, image->pixels->at(i).a, failures);
+                }
+            }
         }else{
-            GetDeflateStaticHuffmanCode(compressedCode->numberValue, code, length, bitReverseLookupTable);
-            AppendBitsToBytesRight(bytes, currentBit, code->numberValue, length->numberValue);
-            AppendBitsToBytesRight(bytes, currentBit, lengthAddition->numberValue, lengthAdditionLength->numberValue);
-            AppendBitsToBytesRight(bytes, currentBit, distanceCode->numberValue, 5.0);
-            AppendBitsToBytesRight(bytes, currentBit, distanceAdditionReference->numberValue, distanceAdditionLengthReference->numberValue);
-            i = i + lengthReference->numberValue;
+            failures->numberValue = failures->numberValue + 1.0;
+        }
+
+        delete png;
+        DeleteImage(imageReference->image);
+        delete imageReference;
+        FreeStringReference(errorMessages);
+    }
+    DeleteImage(image);
+
+    /* raw deflate streams from every encoder back through Inflate */
+    seed = 77;
+    for(i = 0; i < 200000; i++){
+        seed = seed*1103515245 + 12345;
+        bytes.push_back(i % 1000 < 600 ? (seed >> 16) % 4 : (seed >> 16));
+    }
+    for(k = 0; k < 5; k++){
+        if(k == 0){
+            zlibStruct = ZLibCompressNoCompression(&bytes);
+        }else if(k == 1){
+            zlibStruct = ZLibCompressStaticHuffman(&bytes, 3.0);
+        }else if(k == 2){
+            zlibStruct = ZLibCompressDynamicHuffman(&bytes, 7.0);
+        }else if(k == 3){
+            zlibStruct = ZLibCompressParallel(&bytes, 4.0, false, 3.0);
+        }else{
+            zlibStruct = ZLibCompressParallel(&bytes, 4.0, true, 0.5);
         }
+
+        errorMessages = CreateStringReference(toVector(L""));
+        out.clear();
+        if(Inflate(zlibStruct->CompressedDataBlocks->data(), zlibStruct->CompressedDataBlocks->size(), &out, errorMessages)){
+            AssertBooleansEqual(out == bytes, true, failures);
+        }else{
+            failures->numberValue = failures->numberValue + 1.0;
+        }
+        FreeStringReference(errorMessages);
+
+        delete zlibStruct->CompressedDataBlocks;
+        delete zlibStruct;
+    }
+}
+int Adler32SIMDPath(){
+#if defined(PBPLOTS_X86_SIMD)
+    return __builtin_cpu_supports("avx2") ? 2 : 1;
+#elif defined(PBPLOTS_ARM_SIMD)
+    return 1;
+#else
+    return 0;
+#endif
+}
+#if defined(PBPLOTS_X86_SIMD)
+/* The vector blocks keep per-lane sums of the bytes (s1), of s1 before each chunk (ps)
+   and of the bytes weighted by their distance from the chunk end (s2). For n bytes
+   b grows by n*a + chunk*ps + s2. They return the number of bytes consumed. */
+__attribute__((target("sse2")))
+size_t Adler32BlockSSE2(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b){
+    __m128i zero, v, s1, s2, ps, weightsHigh, weightsLow;
+    alignas(16) unsigned int lanes[4];
+    size_t i, n;
+
+    n = length & ~(size_t)15;
+    zero = _mm_setzero_si128();
+    s1 = zero;
+    s2 = zero;
+    ps = zero;
+    weightsHigh = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    weightsLow = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+
+    for(i = 0; i < n; i = i + 16){
+        v = _mm_loadu_si128((const __m128i *)(data + i));
+        ps = _mm_add_epi32(ps, s1);
+        s1 = _mm_add_epi32(s1, _mm_sad_epu8(v, zero));
+        s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weightsHigh));
+        s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weightsLow));
+    }
+
+    *b = *b + n**a;
+    _mm_store_si128((__m128i *)lanes, ps);
+    *b = *b + 16*((unsigned long long)lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    _mm_store_si128((__m128i *)lanes, s2);
+    *b = *b + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm_store_si128((__m128i *)lanes, s1);
+    *a = *a + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    return n;
+}
+__attribute__((target("avx2")))
+size_t Adler32BlockAVX2(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b){
+    __m256i zero, ones, v, s1, s2, ps, weights;
+    alignas(32) unsigned int lanes[8];
+    size_t i, n, k;
+
+    n = length & ~(size_t)31;
+    zero = _mm256_setzero_si256();
+    ones = _mm256_set1_epi16(1);
+    s1 = zero;
+    s2 = zero;
+    ps = zero;
+    weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+
+    for(i = 0; i < n; i = i + 32){
+        v = _mm256_loadu_si256((const __m256i *)(data + i));
+        ps = _mm256_add_epi32(ps, s1);
+        s1 = _mm256_add_epi32(s1, _mm256_sad_epu8(v, zero));
+        s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+    }
+
+    *b = *b + n**a;
+    _mm256_store_si256((__m256i *)lanes, ps);
+    for(k = 0; k < 8; k++){
+        *b = *b + 32*(unsigned long long)lanes[k];
+    }
+    _mm256_store_si256((__m256i *)lanes, s2);
+    for(k = 0; k < 8; k++){
+        *b = *b + lanes[k];
     }
+    _mm256_store_si256((__m256i *)lanes, s1);
+    for(k = 0; k < 8; k++){
+        *a = *a + lanes[k];
+    }
+
+    return n;
+}
+#elif defined(PBPLOTS_ARM_SIMD)
+size_t Adler32BlockNEON(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b){
+    static const unsigned char weightValues[16] = {16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+    uint8x16_t v, weights;
+    uint32x4_t s1, s2, ps;
+    size_t i, n;
+
+    n = length & ~(size_t)15;
+    weights = vld1q_u8(weightValues);
+    s1 = vdupq_n_u32(0);
+    s2 = vdupq_n_u32(0);
+    ps = vdupq_n_u32(0);
+
+    for(i = 0; i < n; i = i + 16){
+        v = vld1q_u8(data + i);
+        ps = vaddq_u32(ps, s1);
+        s1 = vpadalq_u16(s1, vpaddlq_u8(v));
+        s2 = vpadalq_u16(s2, vmull_u8(vget_low_u8(v), vget_low_u8(weights)));
+        s2 = vpadalq_u16(s2, vmull_high_u8(v, weights));
+    }
+
+    *b = *b + n**a + 16*(unsigned long long)vaddvq_u32(ps) + vaddvq_u32(s2);
+    *a = *a + vaddvq_u32(s1);
+
+    return n;
+}
+#endif
+vector<unsigned char> *DeflateDataStaticHuffman(vector<unsigned char> *data, double level){
+    vector<DeflateToken> *tokens;
+    DeflateBitWriter *writer;
+    vector<unsigned char> *bytes;
+
+    tokens = DeflateTokenize(data, 0, level);
+    writer = CreateDeflateBitWriter(data->size()/2 + 64);
 
-    /* Stop symbol */
-    GetDeflateStaticHuffmanCode(256.0, code, length, bitReverseLookupTable);
-    AppendBitsToBytesRight(bytes, currentBit, code->numberValue, length->numberValue);
+    WriteDeflateBlocks(writer, tokens, true, false);
+    DeflateFlushBits(writer);
 
-    copy = new NumberArrayReference();
-    aCopyNumberArrayRange(bytes, 0.0, ceil(currentBit->numberValue/8.0), copy);
-    delete bytes;
-    bytes = copy->numberArray;
+    bytes = writer->bytes;
+    delete writer;
+    delete tokens;
 
     return bytes;
 }
@@ -6517,6 +7601,588 @@ void FindMatch(vector<double> *data, double pos, NumberReference *distanceRefere
         match->booleanValue = false;
     }
 }
+DeflateHashChain *CreateDeflateHashChain(double level){
+    DeflateHashChain *chain;
+
+    chain = new DeflateHashChain();
+    chain->head = new vector<int> (DEFLATE_HASH_SIZE, -1);
+    chain->prev = new vector<int> (DEFLATE_WINDOW_SIZE, -1);
+    chain->inserted = 0;
+
+    /* Same window as FindMatch for a given level. The chain cap can skip a longer match deeper in the window, so output can differ from FindMatch. */
+    chain->maxDistance = fmin(floor(32768.0/10.0*level), DEFLATE_WINDOW_SIZE);
+    chain->maxChainLength = fmax(8.0, floor(4096.0/10.0*level));
+    chain->lazy = level >= 5.0;
+
+    return chain;
+}
+void FreeDeflateHashChain(DeflateHashChain *chain){
+    delete chain->head;
+    delete chain->prev;
+    delete chain;
+}
+size_t DeflateHash(vector<unsigned char> *data, size_t pos){
+    unsigned char *p;
+
+    p = data->data() + pos;
+
+    return ((p[0] << 10) ^ (p[1] << 5) ^ p[2]) & (DEFLATE_HASH_SIZE - 1);
+}
+void DeflateHashChainInsertUpTo(DeflateHashChain *chain, vector<unsigned char> *data, size_t pos){
+    size_t h;
+
+    for(; chain->inserted < pos && chain->inserted + 3 <= data->size(); chain->inserted++){
+        h = DeflateHash(data, chain->inserted);
+        chain->prev->at(chain->inserted & (DEFLATE_WINDOW_SIZE - 1)) = chain->head->at(h);
+        chain->head->at(h) = chain->inserted;
+    }
+    chain->inserted = fmax(chain->inserted, pos);
+}
+void FindLongestMatchHashChain(DeflateHashChain *chain, vector<unsigned char> *data, size_t pos, size_t *distance, size_t *length){
+    size_t longest, matchLength, chainLength;
+    long candidate;
+    unsigned char *a, *b;
+
+    *distance = 0;
+    *length = 0;
+
+    DeflateHashChainInsertUpTo(chain, data, pos);
+
+    /* Limits match the brute-force FindMatch: at most 258 bytes, and never longer than pos - 1. */
+    longest = pos == 0 ? 0 : fmin(pos - 1, DEFLATE_MAX_MATCH);
+    longest = fmin(data->size() - pos, longest);
+
+    if(longest >= DEFLATE_MIN_MATCH){
+        candidate = chain->head->at(DeflateHash(data, pos));
+        b = data->data() + pos;
+
+        for(chainLength = 0; candidate >= 0 && pos - candidate <= chain->maxDistance && chainLength < chain->maxChainLength && *length != longest; chainLength++){
+            a = data->data() + candidate;
+
+            /* A candidate can only improve on the current best if it also matches at that length. */
+            if(*length == 0 || a[*length] == b[*length]){
+                for(matchLength = 0; matchLength < longest && a[matchLength] == b[matchLength]; matchLength++);
+
+                if(matchLength >= DEFLATE_MIN_MATCH && matchLength > *length){
+                    *length = matchLength;
+                    *distance = pos - candidate;
+                }
+            }
+
+            candidate = chain->prev->at(candidate & (DEFLATE_WINDOW_SIZE - 1));
+        }
+    }
+}
+void FindMatchHashChain(DeflateHashChain *chain, vector<unsigned char> *data, double pos, NumberReference *distanceReference, NumberReference *lengthReference, BooleanReference *match){
+    size_t distance, length, nextDistance, nextLength;
+
+    FindLongestMatchHashChain(chain, data, pos, &distance, &length);
+
+    /* Lazy matching: emit a literal instead if the match starting at the next byte is longer. */
+    if(chain->lazy && length >= DEFLATE_MIN_MATCH && length < DEFLATE_MAX_LAZY_MATCH && pos + 1.0 < data->size()){
+        FindLongestMatchHashChain(chain, data, pos + 1.0, &nextDistance, &nextLength);
+        if(nextLength > length){
+            length = 0;
+        }
+    }
+
+    match->booleanValue = length >= DEFLATE_MIN_MATCH;
+    if(match->booleanValue){
+        lengthReference->numberValue = length;
+        distanceReference->numberValue = distance;
+    }
+}
+DeflateBitWriter *CreateDeflateBitWriter(size_t capacity){
+    DeflateBitWriter *writer;
+
+    writer = new DeflateBitWriter();
+    writer->bytes = new vector<unsigned char> ();
+    writer->bytes->reserve(capacity);
+    writer->bitBuffer = 0;
+    writer->bitCount = 0;
+
+    return writer;
+}
+void FreeDeflateBitWriter(DeflateBitWriter *writer){
+    delete writer->bytes;
+    delete writer;
+}
+void DeflateWriteBits(DeflateBitWriter *writer, unsigned int bits, int count){
+    writer->bitBuffer = writer->bitBuffer | ((unsigned long long)bits << writer->bitCount);
+    writer->bitCount = writer->bitCount + count;
+
+    for(; writer->bitCount >= 8; writer->bitCount = writer->bitCount - 8){
+        writer->bytes->push_back(writer->bitBuffer & 0xFF);
+        writer->bitBuffer = writer->bitBuffer >> 8;
+    }
+}
+void DeflateFlushBits(DeflateBitWriter *writer){
+    if(writer->bitCount > 0){
+        writer->bytes->push_back(writer->bitBuffer & 0xFF);
+    }
+    writer->bitBuffer = 0;
+    writer->bitCount = 0;
+}
+static const int deflateLengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const int deflateLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const int deflateDistanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const int deflateDistanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+static const int deflateCodeLengthOrder[DEFLATE_CODE_LENGTH_CODES] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+int DeflateLengthSymbol(int length){
+    int i;
+
+    for(i = 28; deflateLengthBase[i] > length; i--);
+
+    return i;
+}
+int DeflateDistanceSymbol(int distance){
+    int i;
+
+    for(i = 29; deflateDistanceBase[i] > distance; i--);
+
+    return i;
+}
+vector<DeflateToken> *DeflateTokenize(vector<unsigned char> *data, size_t from, double level){
+    vector<DeflateToken> *tokens;
+    DeflateHashChain *chain;
+    NumberReference *distanceReference, *lengthReference;
+    BooleanReference *match;
+    DeflateToken token;
+    size_t i;
+
+    tokens = new vector<DeflateToken> ();
+    tokens->reserve(data->size()/4 + 16);
+
+    chain = CreateDeflateHashChain(level);
+    distanceReference = CreateNumberReference(0.0);
+    lengthReference = CreateNumberReference(0.0);
+    match = new BooleanReference();
+
+    /* Bytes before from are history only: they can be referenced but are not encoded. */
+    DeflateHashChainInsertUpTo(chain, data, from);
+
+    for(i = from; i < data->size(); ){
+        FindMatchHashChain(chain, data, i, distanceReference, lengthReference, match);
+
+        if(match->booleanValue){
+            token.length = lengthReference->numberValue;
+            token.value = distanceReference->numberValue;
+            i = i + token.length;
+        }else{
+            token.length = 0;
+            token.value = data->at(i);
+            i = i + 1;
+        }
+        tokens->push_back(token);
+    }
+
+    FreeDeflateHashChain(chain);
+    delete distanceReference;
+    delete lengthReference;
+    delete match;
+
+    return tokens;
+}
+void DeflateCountFrequencies(vector<DeflateToken> *tokens, size_t from, size_t to, vector<size_t> *literalFrequencies, vector<size_t> *distanceFrequencies){
+    size_t i;
+    DeflateToken *token;
+
+    for(i = from; i < to; i++){
+        token = &tokens->at(i);
+        if(token->length == 0){
+            literalFrequencies->at(token->value)++;
+        }else{
+            literalFrequencies->at(257 + DeflateLengthSymbol(token->length))++;
+            distanceFrequencies->at(DeflateDistanceSymbol(token->value))++;
+        }
+    }
+    /* End of block */
+    literalFrequencies->at(256)++;
+}
+void BuildHuffmanCodeLengths(vector<size_t> *frequencies, int maxLength, vector<int> *lengths){
+    vector<size_t> symbols, weights;
+    vector<int> parents, depths, counts;
+    priority_queue<pair<size_t, size_t>, vector<pair<size_t, size_t> >, greater<pair<size_t, size_t> > > queue;
+    pair<size_t, size_t> a, b;
+    size_t i, j, leaves, maxDepth, next;
+    int length;
+
+    lengths->assign(frequencies->size(), 0);
+
+    for(i = 0; i < frequencies->size(); i++){
+        if(frequencies->at(i) > 0){
+            symbols.push_back(i);
+        }
+    }
+
+    /* A single used symbol still gets a complete one-bit code, with a dummy partner. */
+    if(symbols.size() < 2){
+        lengths->at(0) = 1;
+        lengths->at(1) = 1;
+        if(symbols.size() == 1 && symbols.at(0) > 1){
+            lengths->at(1) = 0;
+            lengths->at(symbols.at(0)) = 1;
+        }
+        return;
+    }
+
+    /* Most frequent first, so they receive the shortest codes when lengths are handed out below. */
+    stable_sort(symbols.begin(), symbols.end(), [frequencies](size_t x, size_t y){
+        return frequencies->at(x) > frequencies->at(y);
+    });
+
+    leaves = symbols.size();
+    for(i = 0; i < leaves; i++){
+        weights.push_back(frequencies->at(symbols.at(i)));
+        parents.push_back(-1);
+        queue.push(make_pair(weights.at(i), i));
+    }
+
+    for(; queue.size() > 1; ){
+        a = queue.top();
+        queue.pop();
+        b = queue.top();
+        queue.pop();
+
+        next = weights.size();
+        weights.push_back(a.first + b.first);
+        parents.push_back(-1);
+        parents.at(a.second) = next;
+        parents.at(b.second) = next;
+        queue.push(make_pair(weights.at(next), next));
+    }
+
+    /* Parents are created after their children, so one backwards pass yields every depth. */
+    depths.assign(weights.size(), 0);
+    maxDepth = 0;
+    for(i = weights.size() - 1; i-- > 0; ){
+        depths.at(i) = depths.at(parents.at(i)) + 1;
+        if(i < leaves){
+            maxDepth = max(maxDepth, (size_t)depths.at(i));
+        }
+    }
+
+    counts.assign(max(maxDepth, (size_t)maxLength) + 1, 0);
+    for(i = 0; i < leaves; i++){
+        counts.at(depths.at(i))++;
+    }
+
+    /* Limit code lengths to maxLength while keeping the code complete (JPEG Annex K.3). */
+    for(i = maxDepth; i > (size_t)maxLength; i--){
+        for(; counts.at(i) > 0; ){
+            for(j = i - 2; counts.at(j) == 0; j--);
+            counts.at(i) = counts.at(i) - 2;
+            counts.at(i - 1) = counts.at(i - 1) + 1;
+            counts.at(j + 1) = counts.at(j + 1) + 2;
+            counts.at(j) = counts.at(j) - 1;
+        }
+    }
+
+    next = 0;
+    for(length = 1; length <= maxLength; length++){
+        for(j = 0; j < (size_t)counts.at(length); j++){
+            lengths->at(symbols.at(next)) = length;
+            next++;
+        }
+    }
+}
+void BuildCanonicalHuffmanCodes(vector<int> *lengths, vector<int> *codes){
+    int counts[DEFLATE_MAX_CODE_LENGTH + 1], nextCode[DEFLATE_MAX_CODE_LENGTH + 1];
+    int code, bits, i, reversed, length;
+    size_t symbol;
+
+    for(i = 0; i <= DEFLATE_MAX_CODE_LENGTH; i++){
+        counts[i] = 0;
+    }
+    for(symbol = 0; symbol < lengths->size(); symbol++){
+        counts[lengths->at(symbol)]++;
+    }
+    counts[0] = 0;
+
+    code = 0;
+    for(bits = 1; bits <= DEFLATE_MAX_CODE_LENGTH; bits++){
+        code = (code + counts[bits - 1]) << 1;
+        nextCode[bits] = code;
+    }
+
+    codes->assign(lengths->size(), 0);
+    for(symbol = 0; symbol < lengths->size(); symbol++){
+        length = lengths->at(symbol);
+        if(length != 0){
+            code = nextCode[length];
+            nextCode[length]++;
+
+            /* Huffman codes are sent most significant bit first into an LSB-first stream. */
+            reversed = 0;
+            for(i = 0; i < length; i++){
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            }
+            codes->at(symbol) = reversed;
+        }
+    }
+}
+void BuildDeflateDynamicHeader(vector<size_t> *literalFrequencies, vector<size_t> *distanceFrequencies, DeflateDynamicHeader *header){
+    vector<int> all;
+    vector<size_t> codeLengthFrequencies(DEFLATE_CODE_LENGTH_CODES, 0);
+    size_t i, run;
+    int value, extraBits;
+
+    BuildHuffmanCodeLengths(literalFrequencies, DEFLATE_MAX_CODE_LENGTH, header->literalLengths);
+    BuildHuffmanCodeLengths(distanceFrequencies, DEFLATE_MAX_CODE_LENGTH, header->distanceLengths);
+
+    for(header->hlit = DEFLATE_LITERAL_CODES; header->hlit > 257 && header->literalLengths->at(header->hlit - 1) == 0; header->hlit--);
+    for(header->hdist = DEFLATE_DISTANCE_CODES; header->hdist > 1 && header->distanceLengths->at(header->hdist - 1) == 0; header->hdist--);
+
+    all.insert(all.end(), header->literalLengths->begin(), header->literalLengths->begin() + header->hlit);
+    all.insert(all.end(), header->distanceLengths->begin(), header->distanceLengths->begin() + header->hdist);
+
+    /* Run-length encode the code lengths with the repeat symbols 16, 17 and 18. */
+    header->codeLengthSymbols->clear();
+    header->codeLengthExtra->clear();
+    for(i = 0; i < all.size(); i = i + run){
+        value = all.at(i);
+        for(run = 1; i + run < all.size() && all.at(i + run) == value; run++);
+
+        if(value == 0 && run >= 11){
+            run = min(run, (size_t)138);
+            header->codeLengthSymbols->push_back(18);
+            header->codeLengthExtra->push_back(run - 11);
+        }else if(value == 0 && run >= 3){
+            run = min(run, (size_t)10);
+            header->codeLengthSymbols->push_back(17);
+            header->codeLengthExtra->push_back(run - 3);
+        }else if(value != 0 && run >= 4){
+            run = min(run, (size_t)7);
+            header->codeLengthSymbols->push_back(value);
+            header->codeLengthExtra->push_back(0);
+            header->codeLengthSymbols->push_back(16);
+            header->codeLengthExtra->push_back(run - 4);
+        }else{
+            run = 1;
+            header->codeLengthSymbols->push_back(value);
+            header->codeLengthExtra->push_back(0);
+        }
+    }
+
+    for(i = 0; i < header->codeLengthSymbols->size(); i++){
+        codeLengthFrequencies.at(header->codeLengthSymbols->at(i))++;
+    }
+    BuildHuffmanCodeLengths(&codeLengthFrequencies, 7, header->codeLengthLengths);
+
+    for(header->hclen = DEFLATE_CODE_LENGTH_CODES; header->hclen > 4 && header->codeLengthLengths->at(deflateCodeLengthOrder[header->hclen - 1]) == 0; header->hclen--);
+
+    header->bits = 5 + 5 + 4 + 3*header->hclen;
+    for(i = 0; i < header->codeLengthSymbols->size(); i++){
+        value = header->codeLengthSymbols->at(i);
+        extraBits = value == 16 ? 2 : value == 17 ? 3 : value == 18 ? 7 : 0;
+        header->bits = header->bits + header->codeLengthLengths->at(value) + extraBits;
+    }
+}
+DeflateDynamicHeader *CreateDeflateDynamicHeader(){
+    DeflateDynamicHeader *header;
+
+    header = new DeflateDynamicHeader();
+    header->literalLengths = new vector<int> ();
+    header->distanceLengths = new vector<int> ();
+    header->codeLengthLengths = new vector<int> ();
+    header->codeLengthSymbols = new vector<int> ();
+    header->codeLengthExtra = new vector<int> ();
+
+    return header;
+}
+void FreeDeflateDynamicHeader(DeflateDynamicHeader *header){
+    delete header->literalLengths;
+    delete header->distanceLengths;
+    delete header->codeLengthLengths;
+    delete header->codeLengthSymbols;
+    delete header->codeLengthExtra;
+    delete header;
+}
+size_t DeflateDynamicBlockBits(vector<size_t> *literalFrequencies, vector<size_t> *distanceFrequencies, DeflateDynamicHeader *header){
+    size_t bits, i;
+
+    BuildDeflateDynamicHeader(literalFrequencies, distanceFrequencies, header);
+
+    bits = 3 + header->bits;
+    for(i = 0; i < DEFLATE_LITERAL_CODES; i++){
+        bits = bits + literalFrequencies->at(i)*header->literalLengths->at(i);
+    }
+    for(i = 0; i < DEFLATE_DISTANCE_CODES; i++){
+        bits = bits + distanceFrequencies->at(i)*header->distanceLengths->at(i);
+    }
+
+    return bits + DeflateExtraBits(literalFrequencies, distanceFrequencies);
+}
+size_t DeflateFixedBlockBits(vector<size_t> *literalFrequencies, vector<size_t> *distanceFrequencies){
+    size_t bits, i;
+
+    bits = 3;
+    for(i = 0; i < DEFLATE_LITERAL_CODES; i++){
+        bits = bits + literalFrequencies->at(i)*(i <= 143 ? 8 : i <= 255 ? 9 : i <= 279 ? 7 : 8);
+    }
+    for(i = 0; i < DEFLATE_DISTANCE_CODES; i++){
+        bits = bits + distanceFrequencies->at(i)*5;
+    }
+
+    return bits + DeflateExtraBits(literalFrequencies, distanceFrequencies);
+}
+size_t DeflateExtraBits(vector<size_t> *literalFrequencies, vector<size_t> *distanceFrequencies){
+    size_t bits, i;
+
+    bits = 0;
+    for(i = 0; i < 29; i++){
+        bits = bits + literalFrequencies->at(257 + i)*deflateLengthExtra[i];
+    }
+    for(i = 0; i < DEFLATE_DISTANCE_CODES; i++){
+        bits = bits + distanceFrequencies->at(i)*deflateDistanceExtra[i];
+    }
+
+    return bits;
+}
+void WriteDeflateTokens(DeflateBitWriter *writer, vector<DeflateToken> *tokens, size_t from, size_t to, vector<int> *literalCodes, vector<int> *literalLengths, vector<int> *distanceCodes, vector<int> *distanceLengths){
+    size_t i;
+    int symbol;
+    DeflateToken *token;
+
+    for(i = from; i < to; i++){
+        token = &tokens->at(i);
+        if(token->length == 0){
+            DeflateWriteBits(writer, literalCodes->at(token->value), literalLengths->at(token->value));
+        }else{
+            symbol = DeflateLengthSymbol(token->length);
+            DeflateWriteBits(writer, literalCodes->at(257 + symbol), literalLengths->at(257 + symbol));
+            DeflateWriteBits(writer, token->length - deflateLengthBase[symbol], deflateLengthExtra[symbol]);
+
+            symbol = DeflateDistanceSymbol(token->value);
+            DeflateWriteBits(writer, distanceCodes->at(symbol), distanceLengths->at(symbol));
+            DeflateWriteBits(writer, token->value - deflateDistanceBase[symbol], deflateDistanceExtra[symbol]);
+        }
+    }
+    DeflateWriteBits(writer, literalCodes->at(256), literalLengths->at(256));
+}
+void WriteDeflateBlock(DeflateBitWriter *writer, vector<DeflateToken> *tokens, size_t from, size_t to, bool final, bool allowDynamic){
+    vector<size_t> literalFrequencies(DEFLATE_LITERAL_CODES, 0), distanceFrequencies(DEFLATE_DISTANCE_CODES, 0);
+    vector<int> literalLengths, distanceLengths, literalCodes, distanceCodes, codeLengthCodes;
+    DeflateDynamicHeader *header;
+    size_t i;
+    int symbol;
+
+    DeflateCountFrequencies(tokens, from, to, &literalFrequencies, &distanceFrequencies);
+    header = CreateDeflateDynamicHeader();
+
+    DeflateWriteBits(writer, final ? 1 : 0, 1);
+
+    if(allowDynamic && DeflateDynamicBlockBits(&literalFrequencies, &distanceFrequencies, header) < DeflateFixedBlockBits(&literalFrequencies, &distanceFrequencies)){
+        DeflateWriteBits(writer, 2, 2);
+        DeflateWriteBits(writer, header->hlit - 257, 5);
+        DeflateWriteBits(writer, header->hdist - 1, 5);
+        DeflateWriteBits(writer, header->hclen - 4, 4);
+
+        BuildCanonicalHuffmanCodes(header->codeLengthLengths, &codeLengthCodes);
+        for(i = 0; i < (size_t)header->hclen; i++){
+            DeflateWriteBits(writer, header->codeLengthLengths->at(deflateCodeLengthOrder[i]), 3);
+        }
+        for(i = 0; i < header->codeLengthSymbols->size(); i++){
+            symbol = header->codeLengthSymbols->at(i);
+            DeflateWriteBits(writer, codeLengthCodes.at(symbol), header->codeLengthLengths->at(symbol));
+            DeflateWriteBits(writer, header->codeLengthExtra->at(i), symbol == 16 ? 2 : symbol == 17 ? 3 : symbol == 18 ? 7 : 0);
+        }
+
+        literalLengths = *header->literalLengths;
+        distanceLengths = *header->distanceLengths;
+    }else{
+        DeflateWriteBits(writer, 1, 2);
+
+        /* The fixed code is defined over 288 symbols, the two unused ones included. */
+        literalLengths.assign(288, 0);
+        for(i = 0; i < literalLengths.size(); i++){
+            literalLengths.at(i) = i <= 143 ? 8 : i <= 255 ? 9 : i <= 279 ? 7 : 8;
+        }
+        distanceLengths.assign(DEFLATE_DISTANCE_CODES, 5);
+    }
+
+    BuildCanonicalHuffmanCodes(&literalLengths, &literalCodes);
+    BuildCanonicalHuffmanCodes(&distanceLengths, &distanceCodes);
+    WriteDeflateTokens(writer, tokens, from, to, &literalCodes, &literalLengths, &distanceCodes, &distanceLengths);
+
+    FreeDeflateDynamicHeader(header);
+}
+vector<unsigned char> *DeflateDataDynamicHuffman(vector<unsigned char> *data, double level){
+    vector<DeflateToken> *tokens;
+    DeflateBitWriter *writer;
+    vector<unsigned char> *bytes;
+
+    tokens = DeflateTokenize(data, 0, level);
+    writer = CreateDeflateBitWriter(data->size()/2 + 64);
+
+    WriteDeflateBlocks(writer, tokens, true, true);
+    DeflateFlushBits(writer);
+
+    bytes = writer->bytes;
+    delete writer;
+    delete tokens;
+
+    return bytes;
+}
+void WriteDeflateBlocks(DeflateBitWriter *writer, vector<DeflateToken> *tokens, bool final, bool allowDynamic){
+    vector<size_t> blockLiterals(DEFLATE_LITERAL_CODES, 0), blockDistances(DEFLATE_DISTANCE_CODES, 0);
+    vector<size_t> chunkLiterals, chunkDistances, mergedLiterals, mergedDistances;
+    DeflateDynamicHeader *header;
+    size_t blockStart, chunkStart, chunkEnd, i, blockBits, chunkBits, mergedBits;
+
+    if(!allowDynamic){
+        WriteDeflateBlock(writer, tokens, 0, tokens->size(), final, false);
+        return;
+    }
+
+    header = CreateDeflateDynamicHeader();
+
+    /* Greedy block splitting: grow the current block chunk by chunk as long as one
+       shared set of codes is cheaper than starting a new block with its own codes. */
+    blockStart = 0;
+    blockBits = 0;
+    for(chunkStart = 0; chunkStart < tokens->size(); chunkStart = chunkEnd){
+        chunkEnd = min(chunkStart + DEFLATE_BLOCK_SPLIT_TOKENS, tokens->size());
+
+        chunkLiterals.assign(DEFLATE_LITERAL_CODES, 0);
+        chunkDistances.assign(DEFLATE_DISTANCE_CODES, 0);
+        DeflateCountFrequencies(tokens, chunkStart, chunkEnd, &chunkLiterals, &chunkDistances);
+        chunkBits = DeflateDynamicBlockBits(&chunkLiterals, &chunkDistances, header);
+
+        if(chunkStart == blockStart){
+            blockLiterals = chunkLiterals;
+            blockDistances = chunkDistances;
+            blockBits = chunkBits;
+        }else{
+            mergedLiterals = blockLiterals;
+            mergedDistances = blockDistances;
+            for(i = 0; i < DEFLATE_LITERAL_CODES; i++){
+                mergedLiterals.at(i) = mergedLiterals.at(i) + chunkLiterals.at(i);
+            }
+            for(i = 0; i < DEFLATE_DISTANCE_CODES; i++){
+                mergedDistances.at(i) = mergedDistances.at(i) + chunkDistances.at(i);
+            }
+            /* Both blocks counted an end-of-block symbol, the merged one only needs one. */
+            mergedLiterals.at(256)--;
+            mergedBits = DeflateDynamicBlockBits(&mergedLiterals, &mergedDistances, header);
+
+            if(mergedBits <= blockBits + chunkBits){
+                blockLiterals = mergedLiterals;
+                blockDistances = mergedDistances;
+                blockBits = mergedBits;
+            }else{
+                WriteDeflateBlock(writer, tokens, blockStart, chunkStart, false, true);
+                blockStart = chunkStart;
+                blockLiterals = chunkLiterals;
+                blockDistances = chunkDistances;
+                blockBits = chunkBits;
+            }
+        }
+    }
+    WriteDeflateBlock(writer, tokens, blockStart, tokens->size(), final, true);
+
+    FreeDeflateDynamicHeader(header);
+}
 vector<double> *GenerateBitReverseLookupTable(double bits){
     vector<double> *table;
     double i;
@@ -6543,34 +8209,392 @@ double ReverseBits(double x, double bits){
 
     return b;
 }
-vector<double> *DeflateDataNoCompression(vector<double> *data){
-    vector<double> *deflated;
-    NumberReference *position;
-    double block, i, blocks, blocklength, maxblocksize;
+vector<unsigned char> *DeflateDataNoCompression(vector<unsigned char> *data){
+    vector<unsigned char> *deflated;
+    size_t block, blocks, blocklength, maxblocksize;
 
-    maxblocksize = pow(2.0, 16.0) - 1.0;
-    blocks = ceil(data->size()/maxblocksize);
+    maxblocksize = 65535;
+    blocks = max((size_t)1, (data->size() + maxblocksize - 1)/maxblocksize);
 
-    position = CreateNumberReference(0.0);
+    deflated = new vector<unsigned char> ();
+    deflated->reserve((1 + 4)*blocks + data->size());
+
+    for(block = 0; block < blocks; block++){
+        deflated->push_back(block + 1 == blocks ? 1 : 0);
+
+        blocklength = min(data->size() - block*maxblocksize, maxblocksize);
+        deflated->push_back(blocklength & 0xFF);
+        deflated->push_back(blocklength >> 8);
+        deflated->push_back(~blocklength & 0xFF);
+        deflated->push_back((~blocklength >> 8) & 0xFF);
+
+        deflated->insert(deflated->end(), data->begin() + block*maxblocksize, data->begin() + block*maxblocksize + blocklength);
+    }
+
+    return deflated;
+}
+InflateHuffman *CreateInflateHuffman(){
+    InflateHuffman *huffman;
+
+    huffman = new InflateHuffman();
+    huffman->fast = new vector<unsigned int> ();
+    huffman->counts = new vector<int> ();
+    huffman->symbols = new vector<int> ();
+
+    return huffman;
+}
+void FreeInflateHuffman(InflateHuffman *huffman){
+    delete huffman->fast;
+    delete huffman->counts;
+    delete huffman->symbols;
+    delete huffman;
+}
+bool BuildInflateHuffman(vector<int> *lengths, InflateHuffman *huffman, bool pairLiterals){
+    vector<int> codes, offsets;
+    vector<unsigned int> single;
+    unsigned int entry, second;
+    size_t symbol, index, step, fastSize;
+    int length, left, firstLength, secondLength;
+
+    fastSize = (size_t)1 << INFLATE_FAST_BITS;
+
+    huffman->counts->assign(DEFLATE_MAX_CODE_LENGTH + 1, 0);
+    for(symbol = 0; symbol < lengths->size(); symbol++){
+        huffman->counts->at(lengths->at(symbol))++;
+    }
+    huffman->counts->at(0) = 0;
+
+    /* Over-subscribed lengths do not describe a prefix code. */
+    left = 1;
+    for(length = 1; length <= DEFLATE_MAX_CODE_LENGTH; length++){
+        left = (left << 1) - huffman->counts->at(length);
+        if(left < 0){
+            return false;
+        }
+    }
+
+    /* Symbols in canonical order, for codes longer than the lookup table. */
+    offsets.assign(DEFLATE_MAX_CODE_LENGTH + 1, 0);
+    for(length = 1; length < DEFLATE_MAX_CODE_LENGTH; length++){
+        offsets.at(length + 1) = offsets.at(length) + huffman->counts->at(length);
+    }
+    huffman->symbols->assign(lengths->size(), 0);
+    for(symbol = 0; symbol < lengths->size(); symbol++){
+        length = lengths->at(symbol);
+        if(length != 0){
+            huffman->symbols->at(offsets.at(length)) = symbol;
+            offsets.at(length)++;
+        }
+    }
+
+    BuildCanonicalHuffmanCodes(lengths, &codes);
+
+    /* Every code of up to INFLATE_FAST_BITS bits fills the table slots that share its low
+       bits. An entry packs the bits used (5 bits), the symbol count (2 bits) and the
+       symbols (9 and 8 bits). A count of 0 sends the decoder to the slow path. */
+    single.assign(fastSize, 0);
+    for(symbol = 0; symbol < lengths->size(); symbol++){
+        length = lengths->at(symbol);
+        if(length != 0 && length <= INFLATE_FAST_BITS){
+            entry = length | 1 << 5 | symbol << 7;
+            step = (size_t)1 << length;
+            for(index = codes.at(symbol); index < fastSize; index = index + step){
+                single.at(index) = entry;
+            }
+        }
+    }
+    *huffman->fast = single;
+
+    /* Two literals whose codes fit in the table together are decoded in one lookup. */
+    if(pairLiterals){
+        for(index = 0; index < fastSize; index++){
+            entry = single.at(index);
+            firstLength = entry & 31;
+            if((entry >> 5 & 3) == 1 && (entry >> 7) < 256 && firstLength < INFLATE_FAST_BITS){
+                second = single.at(index >> firstLength);
+                secondLength = second & 31;
+                if((second >> 5 & 3) == 1 && (second >> 7) < 256 && firstLength + secondLength <= INFLATE_FAST_BITS){
+                    huffman->fast->at(index) = (firstLength + secondLength) | 2 << 5 | (entry >> 7) << 7 | (second >> 7) << 16;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+void InflateRefill(InflateBitReader *reader){
+    for(; reader->bitCount <= 56; reader->bitCount = reader->bitCount + 8){
+        if(reader->position < reader->length){
+            reader->bitBuffer = reader->bitBuffer | (unsigned long long)reader->data[reader->position] << reader->bitCount;
+        }
+        reader->position++;
+    }
+}
+unsigned int InflateReadBits(InflateBitReader *reader, int count){
+    unsigned int bits;
+
+    if(reader->bitCount < count){
+        InflateRefill(reader);
+    }
+    bits = reader->bitBuffer & (((unsigned long long)1 << count) - 1);
+    reader->bitBuffer = reader->bitBuffer >> count;
+    reader->bitCount = reader->bitCount - count;
+
+    return bits;
+}
+bool InflateOverrun(InflateBitReader *reader){
+    return reader->position > reader->length + reader->bitCount/8;
+}
+int InflateDecodeSlow(InflateBitReader *reader, InflateHuffman *huffman){
+    int code, first, index, count, length;
+
+    /* Canonical decoding one bit at a time, as in zlib's puff. */
+    code = 0;
+    first = 0;
+    index = 0;
+    for(length = 1; length <= DEFLATE_MAX_CODE_LENGTH; length++){
+        code = code | InflateReadBits(reader, 1);
+        count = huffman->counts->at(length);
+        if(code - first < count){
+            return huffman->symbols->at(index + code - first);
+        }
+        index = index + count;
+        first = (first + count) << 1;
+        code = code << 1;
+    }
+
+    return -1;
+}
+int InflateDecode(InflateBitReader *reader, InflateHuffman *huffman){
+    unsigned int entry;
+    int length;
+
+    if(reader->bitCount < DEFLATE_MAX_CODE_LENGTH){
+        InflateRefill(reader);
+    }
+    entry = huffman->fast->at(reader->bitBuffer & (((unsigned long long)1 << INFLATE_FAST_BITS) - 1));
+    if((entry >> 5 & 3) == 0){
+        return InflateDecodeSlow(reader, huffman);
+    }
+    length = entry & 31;
+    reader->bitBuffer = reader->bitBuffer >> length;
+    reader->bitCount = reader->bitCount - length;
+
+    return entry >> 7 & 511;
+}
+bool InflateBlock(InflateBitReader *reader, InflateHuffman *literals, InflateHuffman *distances, vector<unsigned char> *out, StringReference *errorMessages){
+    unsigned int entry;
+    int symbol, length, distance, bits;
+    size_t start, i;
+    unsigned char *target;
+
+    for(;;){
+        /* Checked before every symbol, the paired-literal path included: past the end of the
+           input the reader supplies zero bits, which may well decode as literals forever. */
+        if(InflateOverrun(reader)){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Unexpected end of compressed data."));
+            return false;
+        }
+        if(reader->bitCount < 48){
+            InflateRefill(reader);
+        }
+
+        entry = literals->fast->at(reader->bitBuffer & (((unsigned long long)1 << INFLATE_FAST_BITS) - 1));
+        if((entry >> 5 & 3) == 2){
+            bits = entry & 31;
+            reader->bitBuffer = reader->bitBuffer >> bits;
+            reader->bitCount = reader->bitCount - bits;
+            out->push_back(entry >> 7 & 511);
+            out->push_back(entry >> 16 & 255);
+            continue;
+        }
+        symbol = InflateDecode(reader, literals);
+
+        if(symbol < 256){
+            if(symbol < 0){
+                errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid literal/length code."));
+                return false;
+            }
+            out->push_back(symbol);
+        }else if(symbol == 256){
+            return true;
+        }else{
+            symbol = symbol - 257;
+            if(symbol >= 29){
+                errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid length symbol."));
+                return false;
+            }
+            length = deflateLengthBase[symbol] + InflateReadBits(reader, deflateLengthExtra[symbol]);
+
+            symbol = InflateDecode(reader, distances);
+            if(symbol < 0 || symbol >= 30){
+                errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid distance symbol."));
+                return false;
+            }
+            distance = deflateDistanceBase[symbol] + InflateReadBits(reader, deflateDistanceExtra[symbol]);
+            if((size_t)distance > out->size()){
+                errorMessages->string = AppendString(errorMessages->string, toVector(L"Distance too far back."));
+                return false;
+            }
+
+            /* Byte-wise copy, the source may overlap the bytes being written. */
+            start = out->size();
+            out->resize(start + length);
+            target = out->data() + start;
+            for(i = 0; i < (size_t)length; i++){
+                target[i] = target[(ptrdiff_t)i - distance];
+            }
+        }
+    }
+}
+bool InflateDynamicTables(InflateBitReader *reader, InflateHuffman *literals, InflateHuffman *distances, StringReference *errorMessages){
+    vector<int> codeLengthLengths, lengths, literalLengths, distanceLengths;
+    InflateHuffman *codeLengths;
+    int hlit, hdist, hclen, i, symbol, repeat, previous;
+    bool success;
 
-    deflated = new vector<double> ((1.0 + 4.0)*blocks + data->size());
+    hlit = InflateReadBits(reader, 5) + 257;
+    hdist = InflateReadBits(reader, 5) + 1;
+    hclen = InflateReadBits(reader, 4) + 4;
+
+    codeLengthLengths.assign(DEFLATE_CODE_LENGTH_CODES, 0);
+    for(i = 0; i < hclen; i++){
+        codeLengthLengths.at(deflateCodeLengthOrder[i]) = InflateReadBits(reader, 3);
+    }
 
-    for(block = 0.0; block < blocks; block = block + 1.0){
-        if(block + 1.0 == blocks){
-            WriteByte(deflated, 1.0, position);
+    codeLengths = CreateInflateHuffman();
+    success = BuildInflateHuffman(&codeLengthLengths, codeLengths, false);
+
+    lengths.reserve(hlit + hdist);
+    while(success && (int)lengths.size() < hlit + hdist){
+        symbol = InflateDecode(reader, codeLengths);
+        if(symbol < 0){
+            success = false;
+        }else if(symbol < 16){
+            lengths.push_back(symbol);
         }else{
-            WriteByte(deflated, 0.0, position);
+            previous = 0;
+            if(symbol == 16){
+                if(lengths.empty()){
+                    success = false;
+                }else{
+                    previous = lengths.back();
+                }
+                repeat = 3 + InflateReadBits(reader, 2);
+            }else if(symbol == 17){
+                repeat = 3 + InflateReadBits(reader, 3);
+            }else{
+                repeat = 11 + InflateReadBits(reader, 7);
+            }
+            if((int)lengths.size() + repeat > hlit + hdist){
+                success = false;
+            }
+            for(i = 0; success && i < repeat; i++){
+                lengths.push_back(previous);
+            }
+        }
+        if(InflateOverrun(reader)){
+            success = false;
         }
-        blocklength = fmin(data->size() - block*maxblocksize, maxblocksize);
-        Write2BytesLE(deflated, blocklength, position);
-        Write2BytesLE(deflated, Not2Byte(blocklength), position);
+    }
+    FreeInflateHuffman(codeLengths);
+
+    if(success){
+        literalLengths.assign(lengths.begin(), lengths.begin() + hlit);
+        distanceLengths.assign(lengths.begin() + hlit, lengths.end());
+        success = literalLengths.at(256) != 0 && BuildInflateHuffman(&literalLengths, literals, true) && BuildInflateHuffman(&distanceLengths, distances, false);
+    }
+
+    if(!success){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid dynamic Huffman code lengths."));
+    }
+
+    return success;
+}
+bool Inflate(const unsigned char *data, size_t length, vector<unsigned char> *out, StringReference *errorMessages){
+    InflateBitReader reader;
+    InflateHuffman *literals, *distances;
+    vector<int> fixedLiterals, fixedDistances;
+    unsigned int type, stored, storedComplement, i;
+    bool final, success;
+
+    reader.data = data;
+    reader.length = length;
+    reader.position = 0;
+    reader.bitBuffer = 0;
+    reader.bitCount = 0;
 
-        for(i = 0.0; i < blocklength; i = i + 1.0){
-            WriteByte(deflated, data->at(block*maxblocksize + i), position);
+    literals = CreateInflateHuffman();
+    distances = CreateInflateHuffman();
+
+    success = true;
+    for(final = false; success && !final; ){
+        final = InflateReadBits(&reader, 1) == 1;
+        type = InflateReadBits(&reader, 2);
+
+        if(type == 0){
+            /* Stored blocks start on a byte boundary. */
+            InflateReadBits(&reader, reader.bitCount % 8);
+            stored = InflateReadBits(&reader, 16);
+            storedComplement = InflateReadBits(&reader, 16);
+            if((stored ^ 0xFFFF) != storedComplement){
+                errorMessages->string = AppendString(errorMessages->string, toVector(L"Stored block length mismatch."));
+                success = false;
+            }
+            for(i = 0; success && i < stored; i++){
+                out->push_back(InflateReadBits(&reader, 8));
+            }
+        }else if(type == 1){
+            fixedLiterals.assign(288, 8);
+            for(i = 144; i < 256; i++){
+                fixedLiterals.at(i) = 9;
+            }
+            for(i = 256; i < 280; i++){
+                fixedLiterals.at(i) = 7;
+            }
+            fixedDistances.assign(30, 5);
+            BuildInflateHuffman(&fixedLiterals, literals, true);
+            BuildInflateHuffman(&fixedDistances, distances, false);
+            success = InflateBlock(&reader, literals, distances, out, errorMessages);
+        }else if(type == 2){
+            success = InflateDynamicTables(&reader, literals, distances, errorMessages) && InflateBlock(&reader, literals, distances, out, errorMessages);
+        }else{
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid block type."));
+            success = false;
+        }
+
+        if(success && InflateOverrun(&reader)){
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Unexpected end of compressed data."));
+            success = false;
         }
     }
 
-    return deflated;
+    FreeInflateHuffman(literals);
+    FreeInflateHuffman(distances);
+
+    return success;
+}
+bool ZLibUncompress(const unsigned char *data, size_t length, vector<unsigned char> *out, StringReference *errorMessages){
+    unsigned int adler;
+    bool success;
+
+    success = false;
+    if(length < 6){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"zlib stream too short."));
+    }else if((data[0] & 15) != 8 || (data[0]*256 + data[1]) % 31 != 0){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"Invalid zlib header."));
+    }else if(data[1] & 32){
+        errorMessages->string = AppendString(errorMessages->string, toVector(L"zlib preset dictionaries are not supported."));
+    }else if(Inflate(data + 2, length - 6, out, errorMessages)){
+        adler = (unsigned int)data[length - 4] << 24 | (unsigned int)data[length - 3] << 16 | (unsigned int)data[length - 2] << 8 | data[length - 1];
+        if(Adler32OfBytes(out->data(), out->size()) == adler){
+            success = true;
+        }else{
+            errorMessages->string = AppendString(errorMessages->string, toVector(L"Adler-32 checksum mismatch."));
+        }
+    }
+
+    return success;
 }
 void GetDeflateStaticHuffmanCode(double b, NumberReference *code, NumberReference *length, vector<double> *bitReverseLookupTable){
     double reversed;
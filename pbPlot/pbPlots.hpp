@@ -4,6 +4,7 @@
 #include <cstring>
 #include <vector>
 #include <cwchar>
+#include <iosfwd>
 
 #define toVector(s) (new std::vector<wchar_t> ((s), (s) + wcslen(s)))
 
@@ -21,7 +22,7 @@ struct BarPlotSettings;
 
 struct RGBA;
 
-struct RGBABitmap;
+struct RGBAPixel;
 
 struct RGBABitmapImage;
 
@@ -63,6 +64,20 @@ struct LinkedListNodeCharacters;
 
 struct DynamicArrayNumbers;
 
+struct DeflateHashChain;
+
+struct DeflateToken;
+
+struct DeflateBitWriter;
+
+struct DeflateDynamicHeader;
+
+struct PNGStreamWriter;
+
+struct InflateHuffman;
+
+struct InflateBitReader;
+
 struct RGBABitmapImageReference{
     RGBABitmapImage *image;
 };
@@ -145,12 +160,21 @@ struct RGBA{
     double a;
 };
 
-struct RGBABitmap{
-    std::vector<RGBA*> *y;
+/* One pixel of an image. Channels are stored as float to keep the image at
+   16 bytes per pixel while retaining enough precision for repeated blending. */
+struct RGBAPixel{
+    float r;
+    float g;
+    float b;
+    float a;
 };
 
+/* Image backed by a single contiguous, row-major pixel buffer: pixel (x, y)
+   lives at pixels[y*width + x]. */
 struct RGBABitmapImage{
-    std::vector<RGBABitmap*> *x;
+    size_t width;
+    size_t height;
+    std::vector<RGBAPixel> *pixels;
 };
 
 struct BooleanArrayReference{
@@ -203,7 +227,7 @@ struct PHYS{
 };
 
 struct PNGImage{
-    std::vector<double> *signature;
+    std::vector<unsigned char> *signature;
     IHDR *ihdr;
     ZLIBStruct *zlibStruct;
     bool physPresent;
@@ -218,7 +242,7 @@ struct ZLIBStruct{
     double FCHECK;
     double FDICT;
     double FLEVEL;
-    std::vector<double> *CompressedDataBlocks;
+    std::vector<unsigned char> *CompressedDataBlocks;
     double Adler32CheckValue;
 };
 
@@ -260,6 +284,121 @@ struct DynamicArrayNumbers{
     double length;
 };
 
+/* PNG scanline filter types. PNG_FILTER_ADAPTIVE picks, for every row, the filter
+   with the smallest sum of absolute residuals. */
+#define PNG_FILTER_NONE 0
+#define PNG_FILTER_SUB 1
+#define PNG_FILTER_UP 2
+#define PNG_FILTER_AVERAGE 3
+#define PNG_FILTER_PAETH 4
+#define PNG_FILTER_ADAPTIVE 5
+
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_HASH_SIZE 32768
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_MAX_LAZY_MATCH 32
+
+/* Hash-chain match finder for the deflate encoder. head holds the most recent position
+   for every 3-byte hash and prev links each position in the window to the previous one
+   with the same hash, so candidates are visited nearest first. */
+struct DeflateHashChain{
+    std::vector<int> *head;
+    std::vector<int> *prev;
+    size_t inserted;
+    size_t maxDistance;
+    size_t maxChainLength;
+    bool lazy;
+};
+
+#define DEFLATE_LITERAL_CODES 286
+#define DEFLATE_DISTANCE_CODES 30
+#define DEFLATE_CODE_LENGTH_CODES 19
+#define DEFLATE_MAX_CODE_LENGTH 15
+#define DEFLATE_BLOCK_SPLIT_TOKENS 4096
+#define DEFLATE_PARALLEL_SEGMENT_SIZE 131072
+
+/* Largest n for which the Adler-32 sums of n bytes cannot overflow 32 bits before reduction. */
+#define ADLER32_NMAX 5552
+
+/* One LZ77 symbol: a literal byte when length is 0, otherwise a match of length bytes
+   starting value bytes back. */
+struct DeflateToken{
+    unsigned short length;
+    unsigned short value;
+};
+
+/* LSB-first bit writer over a byte buffer, as deflate streams are packed. */
+struct DeflateBitWriter{
+    std::vector<unsigned char> *bytes;
+    unsigned long long bitBuffer;
+    int bitCount;
+};
+
+/* Code lengths of one dynamic-Huffman block together with their run-length encoded
+   form and the total size of the block header in bits. */
+struct DeflateDynamicHeader{
+    std::vector<int> *literalLengths;
+    std::vector<int> *distanceLengths;
+    std::vector<int> *codeLengthLengths;
+    std::vector<int> *codeLengthSymbols;
+    std::vector<int> *codeLengthExtra;
+    int hlit;
+    int hdist;
+    int hclen;
+    size_t bits;
+};
+
+#define PNG_STREAM_BLOCK_SIZE 262144
+#define PNG_STREAM_IDAT_SIZE 65536
+
+/* Incremental PNG encoder: rows are filtered as they arrive and compressed every
+   PNG_STREAM_BLOCK_SIZE bytes into non-final deflate blocks, with the last 32 KiB kept
+   as match history. Compressed output leaves as IDAT chunks of PNG_STREAM_IDAT_SIZE
+   bytes, so memory use does not depend on the image height. */
+struct PNGStreamWriter{
+    std::ostream *out;
+    size_t width;
+    size_t height;
+    double colorType;
+    size_t bytesPerPixel;
+    double filterType;
+    double level;
+    bool dynamic;
+    size_t rowsWritten;
+    unsigned int adler;
+    std::vector<unsigned char> *raw;
+    std::vector<unsigned char> *previous;
+    std::vector<unsigned char> *window;
+    size_t windowStart;
+    DeflateBitWriter *deflate;
+    std::vector<unsigned char> *idat;
+};
+
+#define INFLATE_FAST_BITS 11
+/* Most output one byte of deflate data can expand to: a 258-byte match in as little as two bits. */
+#define INFLATE_MAX_RATIO 1032
+/* Largest width or height a PNG may declare. */
+#define PNG_MAX_DIMENSION 2147483647
+
+/* Decoding tables of one Huffman code. fast is indexed by the next INFLATE_FAST_BITS
+   input bits and may yield two literals at once, longer codes are decoded canonically
+   from counts and symbols. */
+struct InflateHuffman{
+    std::vector<unsigned int> *fast;
+    std::vector<int> *counts;
+    std::vector<int> *symbols;
+};
+
+/* LSB-first bit reader, reads past the end return zero bits and are caught by InflateOverrun. */
+struct InflateBitReader{
+    const unsigned char *data;
+    size_t length;
+    size_t position;
+    unsigned long long bitBuffer;
+    int bitCount;
+};
+
 bool CropLineWithinBoundary(NumberReference *x1Ref, NumberReference *y1Ref, NumberReference *x2Ref, NumberReference *y2Ref, double xMin, double xMax, double yMin, double yMax);
 double IncrementFromCoordinates(double x1, double y1, double x2, double y2);
 double InterceptFromCoordinates(double x1, double y1, double x2, double y2);
@@ -323,8 +462,10 @@ RGBABitmapImage *CreateImage(double w, double h, RGBA *color);
 void DeleteImage(RGBABitmapImage *image);
 double ImageWidth(RGBABitmapImage *image);
 double ImageHeight(RGBABitmapImage *image);
+RGBAPixel *ImagePixelAt(RGBABitmapImage *image, double x, double y);
 void SetPixel(RGBABitmapImage *image, double x, double y, RGBA *color);
 void DrawPixel(RGBABitmapImage *image, double x, double y, RGBA *color);
+void BlendPixel(RGBAPixel *pixel, double ra, double ga, double ba, double aa);
 double CombineAlpha(double as, double ad);
 double AlphaBlend(double cs, double as, double cd, double ad, double ao);
 void DrawHorizontalLine1px(RGBABitmapImage *image, double x, double y, double length, RGBA *color);
@@ -506,21 +647,41 @@ void AssertNumberArraysEqual(std::vector<double> *a, std::vector<double> *b, Num
 void AssertBooleanArraysEqual(std::vector<bool> *a, std::vector<bool> *b, NumberReference *failures);
 void AssertStringArraysEqual(std::vector<StringReference*> *a, std::vector<StringReference*> *b, NumberReference *failures);
 
-std::vector<double> *ConvertToPNG(RGBABitmapImage *image);
-std::vector<double> *ConvertToPNGGrayscale(RGBABitmapImage *image);
+std::vector<unsigned char> *ConvertToPNG(RGBABitmapImage *image);
+std::vector<unsigned char> *ConvertToPNGGrayscale(RGBABitmapImage *image);
 PHYS *PysicsHeader(double pixelsPerMeter);
-std::vector<double> *ConvertToPNGWithOptions(RGBABitmapImage *image, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel);
-std::vector<double> *PNGSerializeChunks(PNGImage *png);
+std::vector<unsigned char> *ConvertToPNGWithOptions(RGBABitmapImage *image, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, double threads, StringReference *errorMessages);
+std::vector<unsigned char> *PNGSerializeChunks(PNGImage *png);
+void AppendUInt32BE(std::vector<unsigned char> *data, unsigned int value);
+size_t PNGBeginChunk(std::vector<unsigned char> *data, const char *type, size_t length);
+void PNGEndChunk(std::vector<unsigned char> *data, size_t chunkStart);
+PNGStreamWriter *CreatePNGStreamWriter(std::ostream *out, double width, double height, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, StringReference *errorMessages);
+void PNGStreamWriteRow(PNGStreamWriter *writer, RGBAPixel *pixels);
+void PNGStreamWriteImage(PNGStreamWriter *writer, RGBABitmapImage *image);
+void PNGStreamCompressPending(PNGStreamWriter *writer, bool final);
+void PNGStreamFlushIDAT(PNGStreamWriter *writer, bool all);
+bool FinishPNGStreamWriter(PNGStreamWriter *writer);
+bool ConvertToPNGStream(RGBABitmapImage *image, std::ostream *out, double colorType, bool setPhys, double pixelsPerMeter, double compressionLevel, double filterType, StringReference *errorMessages);
 double PNGIDATLength(PNGImage *png);
 double PNGHeaderLength();
-std::vector<double> *GetPNGColorData(RGBABitmapImage *image);
-std::vector<double> *GetPNGColorDataGreyscale(RGBABitmapImage *image);
+std::vector<unsigned char> *GetPNGColorData(RGBABitmapImage *image);
+std::vector<unsigned char> *GetPNGColorDataGreyscale(RGBABitmapImage *image);
+void PNGPixelsToBytes(RGBAPixel *pixels, size_t width, double colorType, unsigned char *out);
+int PNGPaethPredictor(int a, int b, int c);
+void PNGFilterRow(int filterType, unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel, unsigned char *out);
+size_t PNGFilterCost(unsigned char *filtered, size_t stride);
+bool PNGFilterTypeValid(double filterType, StringReference *errorMessages);
+int PNGFilterRowWithType(unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel, double filterType, unsigned char *out);
+void PNGFilterScanlines(std::vector<unsigned char> *colorData, double width, double height, double bytesPerPixel, double filterType);
 IHDR *PNGHeader(RGBABitmapImage *image, double colortype);
-std::vector<double> *PNGSignature();
+std::vector<unsigned char> *PNGSignature();
 std::vector<double> *PNGReadDataChunks(std::vector<Chunk*> *cs);
 bool PNGReadHeader(RGBABitmapImage *image, std::vector<Chunk*> *cs, StringReference *errorMessages);
 std::vector<Chunk*> *PNGReadChunks(std::vector<double> *data, NumberReference *position);
 Chunk *PNGReadChunk(std::vector<double> *data, NumberReference *position);
+bool ReadPNG(RGBABitmapImageReference *imageReference, std::vector<unsigned char> *data, StringReference *errorMessages);
+bool PNGUnfilterRow(int type, unsigned char *row, unsigned char *previous, size_t stride, size_t bytesPerPixel);
+void PNGBytesToPixels(unsigned char *bytes, size_t width, int colorType, RGBAPixel *pixels);
 
 void WriteStringToStingStream(std::vector<wchar_t> *stream, NumberReference *index, std::vector<wchar_t> *src);
 void WriteCharacterToStingStream(std::vector<wchar_t> *stream, NumberReference *index, wchar_t src);
@@ -567,8 +728,31 @@ double UpdateCRC32(double crc, std::vector<double> *buf, std::vector<double> *cr
 double CalculateCRC32(std::vector<double> *buf);
 double CRC32OfInterval(std::vector<double> *data, double from, double length);
 
-ZLIBStruct *ZLibCompressNoCompression(std::vector<double> *data);
-ZLIBStruct *ZLibCompressStaticHuffman(std::vector<double> *data, double level);
+unsigned int CRC32OfBytes(const unsigned char *data, size_t length);
+const unsigned int *CRC32SliceTables();
+std::vector<unsigned int> *BuildCRC32SliceTables();
+unsigned int UpdateCRC32Slice8(unsigned int crc, const unsigned char *data, size_t length);
+unsigned int UpdateCRC32Clmul(unsigned int crc, const unsigned char *data, size_t length);
+bool CRC32HardwareAvailable();
+unsigned int UpdateCRC32Bytes(unsigned int crc, const unsigned char *data, size_t length);
+ZLIBStruct *ZLibCompressNoCompression(std::vector<unsigned char> *data);
+ZLIBStruct *ZLibCompressStaticHuffman(std::vector<unsigned char> *data, double level);
+ZLIBStruct *ZLibCompressDynamicHuffman(std::vector<unsigned char> *data, double level);
+ZLIBStruct *ZLibCompressParallel(std::vector<unsigned char> *data, double level, bool dynamic, double threads);
+std::vector<unsigned char> *DeflateSegment(std::vector<unsigned char> *data, size_t start, size_t end, double level, bool dynamic, bool final);
+void DeflateWriteSyncFlush(DeflateBitWriter *writer);
+InflateHuffman *CreateInflateHuffman();
+void FreeInflateHuffman(InflateHuffman *huffman);
+bool BuildInflateHuffman(std::vector<int> *lengths, InflateHuffman *huffman, bool pairLiterals);
+void InflateRefill(InflateBitReader *reader);
+unsigned int InflateReadBits(InflateBitReader *reader, int count);
+bool InflateOverrun(InflateBitReader *reader);
+int InflateDecodeSlow(InflateBitReader *reader, InflateHuffman *huffman);
+int InflateDecode(InflateBitReader *reader, InflateHuffman *huffman);
+bool InflateBlock(InflateBitReader *reader, InflateHuffman *literals, InflateHuffman *distances, std::vector<unsigned char> *out, StringReference *errorMessages);
+bool InflateDynamicTables(InflateBitReader *reader, InflateHuffman *literals, InflateHuffman *distances, StringReference *errorMessages);
+bool Inflate(const unsigned char *data, size_t length, std::vector<unsigned char> *out, StringReference *errorMessages);
+bool ZLibUncompress(const unsigned char *data, size_t length, std::vector<unsigned char> *out, StringReference *errorMessages);
 
 std::vector<double> *AddNumber(std::vector<double> *list, double a);
 void AddNumberRef(NumberArrayReference *list, double i);
@@ -687,11 +871,48 @@ double Read2bytesByteBoundary(std::vector<double> *data, NumberReference *nextbi
 
 double ComputeAdler32(std::vector<double> *data);
 
-std::vector<double> *DeflateDataStaticHuffman(std::vector<double> *data, double level);
+unsigned int Adler32OfBytes(const unsigned char *data, size_t length);
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char *data, size_t length);
+unsigned int UpdateAdler32WithPath(unsigned int adler, const unsigned char *data, size_t length, int path);
+void TestAdler32(NumberReference *failures);
+void TestCRC32(NumberReference *failures);
+void TestPNGRoundTrip(NumberReference *failures);
+void Adler32BlockScalar(const unsigned char *data, size_t length, unsigned long long *aReference, unsigned long long *bReference);
+int Adler32SIMDPath();
+size_t Adler32BlockSSE2(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b);
+size_t Adler32BlockAVX2(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b);
+size_t Adler32BlockNEON(const unsigned char *data, size_t length, unsigned long long *a, unsigned long long *b);
+std::vector<unsigned char> *DeflateDataStaticHuffman(std::vector<unsigned char> *data, double level);
 void FindMatch(std::vector<double> *data, double pos, NumberReference *distanceReference, NumberReference *lengthReference, BooleanReference *match, double level);
+DeflateHashChain *CreateDeflateHashChain(double level);
+void FreeDeflateHashChain(DeflateHashChain *chain);
+size_t DeflateHash(std::vector<unsigned char> *data, size_t pos);
+void DeflateHashChainInsertUpTo(DeflateHashChain *chain, std::vector<unsigned char> *data, size_t pos);
+void FindLongestMatchHashChain(DeflateHashChain *chain, std::vector<unsigned char> *data, size_t pos, size_t *distance, size_t *length);
+void FindMatchHashChain(DeflateHashChain *chain, std::vector<unsigned char> *data, double pos, NumberReference *distanceReference, NumberReference *lengthReference, BooleanReference *match);
+DeflateBitWriter *CreateDeflateBitWriter(size_t capacity);
+void FreeDeflateBitWriter(DeflateBitWriter *writer);
+void DeflateWriteBits(DeflateBitWriter *writer, unsigned int bits, int count);
+void DeflateFlushBits(DeflateBitWriter *writer);
+int DeflateLengthSymbol(int length);
+int DeflateDistanceSymbol(int distance);
+std::vector<DeflateToken> *DeflateTokenize(std::vector<unsigned char> *data, size_t from, double level);
+void DeflateCountFrequencies(std::vector<DeflateToken> *tokens, size_t from, size_t to, std::vector<size_t> *literalFrequencies, std::vector<size_t> *distanceFrequencies);
+void BuildHuffmanCodeLengths(std::vector<size_t> *frequencies, int maxLength, std::vector<int> *lengths);
+void BuildCanonicalHuffmanCodes(std::vector<int> *lengths, std::vector<int> *codes);
+void BuildDeflateDynamicHeader(std::vector<size_t> *literalFrequencies, std::vector<size_t> *distanceFrequencies, DeflateDynamicHeader *header);
+DeflateDynamicHeader *CreateDeflateDynamicHeader();
+void FreeDeflateDynamicHeader(DeflateDynamicHeader *header);
+size_t DeflateDynamicBlockBits(std::vector<size_t> *literalFrequencies, std::vector<size_t> *distanceFrequencies, DeflateDynamicHeader *header);
+size_t DeflateFixedBlockBits(std::vector<size_t> *literalFrequencies, std::vector<size_t> *distanceFrequencies);
+size_t DeflateExtraBits(std::vector<size_t> *literalFrequencies, std::vector<size_t> *distanceFrequencies);
+void WriteDeflateTokens(DeflateBitWriter *writer, std::vector<DeflateToken> *tokens, size_t from, size_t to, std::vector<int> *literalCodes, std::vector<int> *literalLengths, std::vector<int> *distanceCodes, std::vector<int> *distanceLengths);
+void WriteDeflateBlock(DeflateBitWriter *writer, std::vector<DeflateToken> *tokens, size_t from, size_t to, bool final, bool allowDynamic);
+std::vector<unsigned char> *DeflateDataDynamicHuffman(std::vector<unsigned char> *data, double level);
+void WriteDeflateBlocks(DeflateBitWriter *writer, std::vector<DeflateToken> *tokens, bool final, bool allowDynamic);
 std::vector<double> *GenerateBitReverseLookupTable(double bits);
 double ReverseBits(double x, double bits);
-std::vector<double> *DeflateDataNoCompression(std::vector<double> *data);
+std::vector<unsigned char> *DeflateDataNoCompression(std::vector<unsigned char> *data);
 void GetDeflateStaticHuffmanCode(double b, NumberReference *code, NumberReference *length, std::vector<double> *bitReverseLookupTable);
 void GetDeflateLengthCode(double length, NumberReference *code, NumberReference *lengthAddition, NumberReference *lengthAdditionLength);
 void GetDeflateDistanceCode(double distance, NumberReference *code, NumberReference *distanceAdditionReference, NumberReference *distanceAdditionLengthReference, std::vector<double> *bitReverseLookupTable);
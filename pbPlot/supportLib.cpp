@@ -24,7 +24,28 @@ void WriteToFile(vector<double> *data, string filename){
 	file.write(reinterpret_cast<char *>(bytes), data->size());
 	file.close();
 
-	delete bytes;
+	delete[] bytes;
+}
+
+void WriteToFile(vector<unsigned char> *data, string filename){
+	ofstream file(filename.c_str(), ios::binary);
+	file.write(reinterpret_cast<char *>(data->data()), data->size());
+	file.close();
+}
+
+vector<unsigned char> *ReadFile(string filename){
+	vector<unsigned char> *data;
+	ifstream file(filename.c_str(), ios::binary | ios::ate);
+
+	data = new vector<unsigned char>();
+
+	if(file){
+		data->resize(file.tellg());
+		file.seekg(0);
+		file.read(reinterpret_cast<char *>(data->data()), data->size());
+	}
+
+	return data;
 }
 
 vector<double> *ByteArrayToDoubleArray(vector<unsigned char> *data){
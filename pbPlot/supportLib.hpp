@@ -5,4 +5,6 @@
 
 unsigned char *DoubleArrayToByteArray(std::vector<double> *data);
 void WriteToFile(std::vector<double> *data, std::string filename);
+void WriteToFile(std::vector<unsigned char> *data, std::string filename);
+std::vector<unsigned char> *ReadFile(std::string filename);
 std::vector<double> *ByteArrayToDoubleArray(std::vector<unsigned char> *data);
@@ -0,0 +1,99 @@
+#include "portfolio.hpp"
+
+using namespace std;
+
+/**
+ * @brief Appends a year slot, zero for every project added so far.
+ */
+void Portfolio::addSlot() {
+    for (auto *column: {&year, &cashFlow, &discount})
+        column->emplace_back(size(), 0.0);
+}
+
+size_t Portfolio::add(const string &name, span<const double> years, span<const double> operating,
+                      span<const double> capital, span<const double> revenues, double tax, double rate) {
+    if (operating.size() != years.size() || capital.size() != years.size() || revenues.size() != years.size())
+        return npos;
+
+    size_t p = names.size();
+    while (cashFlow.size() < years.size())
+        addSlot();
+
+    names.push_back(name);
+    taxRate.push_back(tax);
+    discountRate.push_back(rate);
+
+    // 1 / (1 + r)^t by repeated multiplication from the last whole year, a single multiply per
+    // year for the usual 0, 1, 2, ... schedule; pow only for fractional or negative years
+    double v = 1 / (1 + rate / 100), power = 1, powerYear = 0;
+    auto discountFactor = [&](double t) {
+        if (t < 0 || t != floor(t))
+            return 1 / pow(1 + rate / 100, t);
+        if (t < powerYear) {
+            power = 1;
+            powerYear = 0;
+        }
+        for (; powerYear < t; ++powerYear)
+            power *= v;
+        return power;
+    };
+
+    for (size_t t = 0; t < cashFlow.size(); ++t) {
+        if (t < years.size()) {
+            year[t].push_back(years[t]);
+            cashFlow[t].push_back((revenues[t] - operating[t]) * (1 - tax / 100) - capital[t]);
+            discount[t].push_back(discountFactor(years[t]));
+        } else {
+            for (auto *column: {&year, &cashFlow, &discount})
+                (*column)[t].push_back(0);
+        }
+    }
+
+    return p;
+}
+
+void Portfolio::npv(double *out, ThreadPool *pool) const {
+    size_t projects = size();
+    size_t blocks = (projects + PORTFOLIO_BLOCK - 1) / PORTFOLIO_BLOCK;
+
+    auto block = [&](size_t b) {
+        size_t first = b * PORTFOLIO_BLOCK, n = min<size_t>(PORTFOLIO_BLOCK, projects - first);
+        double *o = out + first;
+
+        fill(o, o + n, 0.0);
+        for (size_t t = 0; t < cashFlow.size(); ++t) {
+            const double *cf = cashFlow[t].data() + first, *df = discount[t].data() + first;
+#pragma omp simd
+            for (size_t k = 0; k < n; ++k)
+                o[k] += cf[k] * df[k];
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, blocks, 1, block);
+    else
+        for (size_t b = 0; b < blocks; ++b)
+            block(b);
+}
+
+void Portfolio::irr(IrrResult *out, ThreadPool *pool, double tolerance) const {
+    size_t projects = size();
+    size_t blocks = (projects + PORTFOLIO_BLOCK - 1) / PORTFOLIO_BLOCK;
+
+    auto block = [&](size_t b) {
+        vector<double> years(cashFlow.size()), flows(cashFlow.size());
+        for (size_t p = b * PORTFOLIO_BLOCK; p < min(projects, (b + 1) * PORTFOLIO_BLOCK); ++p) {
+            for (size_t t = 0; t < cashFlow.size(); ++t) {
+                years[t] = year[t][p];
+                flows[t] = cashFlow[t][p];
+            }
+            out[p] = ::irr(years, flows, tolerance);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, blocks, 1, block);
+    else
+        for (size_t b = 0; b < blocks; ++b)
+            block(b);
+}
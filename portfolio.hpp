@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "irr.hpp"
+#include "project.hpp"
+#include "thread_pool.hpp"
+
+#define PORTFOLIO_BLOCK 2048    // projects per task, a block of NPVs stays in L1 across the year loop
+
+/**
+ * Many projects evaluated together.
+ *
+ * The projects are stored as a structure of arrays: column t of each field holds year slot t of
+ * every project, so the NPV loop streams through contiguous memory and vectorizes across
+ * projects. Projects with fewer years are padded with zero cash flows. Only the years, the
+ * after-tax cash flows and the discount factors are kept; the discount factors are computed
+ * once, when a project is added.
+ */
+class Portfolio {
+public:
+    /** Returned by add() when a project is rejected. */
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * @brief Adds a project to the portfolio.
+     *
+     * @param project - the project to copy the cash flows of
+     * @return the index of the project in the results, or npos if its columns differ in length
+     */
+    template<typename T>
+    std::size_t add(const Project<T> &project) {
+        if constexpr (std::is_same_v<T, double>)
+            return add(project.getName(), project.getYear(), project.getOperatingCost(), project.getCapitalCost(),
+                       project.getRevenue(), project.getTaxRate(), project.getDiscountRate());
+
+        std::vector<double> year(project.getYear().begin(), project.getYear().end());
+        std::vector<double> operatingCost(project.getOperatingCost().begin(), project.getOperatingCost().end());
+        std::vector<double> capitalCost(project.getCapitalCost().begin(), project.getCapitalCost().end());
+        std::vector<double> revenue(project.getRevenue().begin(), project.getRevenue().end());
+
+        return add(project.getName(), year, operatingCost, capitalCost, revenue, project.getTaxRate(),
+                   project.getDiscountRate());
+    }
+
+    /**
+     * @brief Adds a project given as columns, e.g. straight from a ProjectTable, without building a Project.
+     *
+     * @return the index of the project in the results, or npos, with nothing added, if the four
+     * columns are not all the same length
+     */
+    std::size_t add(const std::string &name, std::span<const double> year, std::span<const double> operatingCost,
+                    std::span<const double> capitalCost, std::span<const double> revenue, double taxRate,
+                    double discountRate);
+
+    std::size_t size() const {
+        return names.size();
+    }
+
+    std::size_t getYears() const {
+        return cashFlow.size();
+    }
+
+    const std::string &getName(std::size_t p) const {
+        return names[p];
+    }
+
+    /**
+     * @brief NPV of every project at its own discount rate.
+     *
+     * @param out - receives size() values, in the order the projects were added
+     * @param pool - the pool to spread the blocks of projects over, or nullptr to run on the calling thread
+     */
+    void npv(double *out, ThreadPool *pool = nullptr) const;
+
+    std::vector<double> npv(ThreadPool *pool = nullptr) const {
+        std::vector<double> out(size());
+        npv(out.data(), pool);
+        return out;
+    }
+
+    /**
+     * @brief IRR of every project, see irr().
+     *
+     * @param out - receives size() results, in the order the projects were added
+     * @param pool - the pool to spread the blocks of projects over, or nullptr to run on the calling thread
+     * @param tolerance - the accuracy of the rates, in percentage points
+     */
+    void irr(IrrResult *out, ThreadPool *pool = nullptr, double tolerance = 1e-10) const;
+
+    std::vector<IrrResult> irr(ThreadPool *pool = nullptr, double tolerance = 1e-10) const {
+        std::vector<IrrResult> out(size());
+        irr(out.data(), pool, tolerance);
+        return out;
+    }
+
+private:
+    void addSlot();
+
+    std::vector<std::string> names;
+    std::vector<double> taxRate, discountRate;
+    std::vector<std::vector<double>> year, cashFlow, discount;
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define MAX_ITERATIONS 10000
+
+template<typename T>
+class Project {
+public:
+    // the columns are taken by value and moved in, so callers that pass temporaries (or std::move
+    // their vectors) hand over the buffers instead of having them copied
+    Project(std::string name,
+            std::vector<T> year,
+            std::vector<T> operating_cost,
+            std::vector<T> capital_cost,
+            std::vector<T> revenue,
+            const T tax_rate,
+            const T discount_rate
+    ) {
+        this->name = std::move(name);
+        this->year = std::move(year);
+        this->operating_cost = std::move(operating_cost);
+        this->capital_cost = std::move(capital_cost);
+        this->revenue = std::move(revenue);
+        this->discount_rate = discount_rate;
+        this->tax_rate = tax_rate;
+    }
+
+    float getNpv() {
+        float npv = 0.0;
+        for (int i = 0; i < year.size(); ++i) {
+            auto cf = ((revenue[i] - operating_cost[i]) * (1 - tax_rate / 100) - capital_cost[i]);
+            npv += cf / std::pow(1 + discount_rate / 100, year[i]);
+        }
+        return npv;
+    }
+
+    float getIrr() {
+        float r = 2;
+        float eps = 0.01;
+
+        for (int x = 0; x < MAX_ITERATIONS; ++x) {
+            float n = 0.0;
+            float d = 0.0;
+            for (int i = 0; i < year.size(); ++i) {
+                auto cf = ((revenue[i] - operating_cost[i]) * (1 - tax_rate / 100) - capital_cost[i]);
+                n += cf / std::pow(1 + r / 100, year[i]);
+                d += ((-year[i]) * cf) / (100 * std::pow(1 + r / 100, year[i] + 1));
+            }
+
+            if (std::abs(n / d) < eps)
+                return r;
+            else
+                r -= n / d;
+        }
+
+        return r;
+    }
+
+    std::string getName() const {
+        return name;
+    }
+
+    const std::vector<T> &getYear() const {
+        return year;
+    }
+
+    const std::vector<T> &getOperatingCost() const {
+        return operating_cost;
+    }
+
+    const std::vector<T> &getCapitalCost() const {
+        return capital_cost;
+    }
+
+    const std::vector<T> &getRevenue() const {
+        return revenue;
+    }
+
+    T getTaxRate() const {
+        return tax_rate;
+    }
+
+    T getDiscountRate() const {
+        return discount_rate;
+    }
+
+private:
+    std::string name;
+    std::vector<T> year;
+    std::vector<T> operating_cost;
+    std::vector<T> capital_cost;
+    std::vector<T> revenue;
+    T discount_rate;
+    T tax_rate;
+};
+
+/**
+ * The columns of one project as plain doubles, the form the analysis code works on.
+ */
+struct ProjectCashFlows {
+    std::vector<double> year, revenue, operatingCost, capitalCost;
+    double taxRate = 0, discountRate = 0;
+};
+
+template<typename T>
+ProjectCashFlows cashFlowsOf(const Project<T> &project) {
+    return {{project.getYear().begin(), project.getYear().end()},
+            {project.getRevenue().begin(), project.getRevenue().end()},
+            {project.getOperatingCost().begin(), project.getOperatingCost().end()},
+            {project.getCapitalCost().begin(), project.getCapitalCost().end()},
+            (double) project.getTaxRate(), (double) project.getDiscountRate()};
+}
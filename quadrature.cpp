@@ -0,0 +1,44 @@
+#include "quadrature.hpp"
+
+/**
+ * @brief Calculates the integral of f(x) from a to b using the trapezoidal rule.
+ *
+ * @param n - number of intervals
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param f - the function to integrate
+ * @return the area under the curve
+ */
+double trapezoidal(int n, double (*f)(double), double a, double b) {
+    double h = (b - a) / n;
+
+    double Tn = f(a) + f(b);        // first and last term
+    for (int i = 1; i < n; ++i)      // middle terms
+        Tn += 2 * f(a + i * h);
+    Tn *= h / 2;
+
+    return Tn;
+}
+
+/**
+ * @brief Calculates the integral of f(x) from a to b using the Simpson's ⅓ rule.
+ *
+ * @param n - number of intervals
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param f - the function to integrate
+ * @return the area under the curve
+ */
+double simpsons(int n, double (*f)(double), double a, double b) {
+    double h = (b - a) / n;
+
+    double Tn = f(a) + f(b);        // first and last term
+    for (int i = 1; i < n; ++i)
+        if (i % 2)
+            Tn += 4 * f(a + i * h);     // odd terms
+        else
+            Tn += 2 * f(a + i * h);     // even terms
+    Tn *= h / 3;
+
+    return Tn;
+}
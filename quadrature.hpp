@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include "summation.hpp"
+
+#define QUADRATURE_BATCH_SIZE 256     // even, so Simpson batches keep the same weight pattern
+
+/**
+ * Anything that can be called with a double and returns something convertible to double:
+ * plain functions, lambdas, or functor classes such as F1 and F2.
+ */
+template<typename F>
+concept Integrand = std::invocable<F &, double> &&
+                    std::convertible_to<std::invoke_result_t<F &, double>, double>;
+
+/**
+ * An integrand that can also fill y[i] = f(x[i]) for a whole array at once, which lets it
+ * use vectorized math instead of one call per point.
+ */
+template<typename F>
+concept BatchIntegrand = Integrand<F> && requires(const F &f, const double *x, double *y, std::size_t n) {
+    f.eval(x, y, n);
+};
+
+/**
+ * @brief Evaluates f on the n nodes a + (first + k) h, k = 0..n-1, into y.
+ */
+template<Integrand F>
+void evalNodes(F &&f, double a, double h, long long first, double *y, std::size_t n) {
+    if constexpr (BatchIntegrand<std::remove_cvref_t<F>>) {
+        double x[QUADRATURE_BATCH_SIZE];
+        for (std::size_t k = 0; k < n; ++k)
+            x[k] = a + (first + (long long) k) * h;
+        f.eval(x, y, n);
+    } else {
+        for (std::size_t k = 0; k < n; ++k)
+            y[k] = f(a + (first + (long long) k) * h);
+    }
+}
+
+/**
+ * @brief Calculates the integral of f(x) from a to b using the trapezoidal rule.
+ *
+ * The integrand is a template parameter, so calls to it can be inlined and the loop
+ * vectorized. Plain function pointers still resolve to the non-template overload.
+ *
+ * @param n - number of intervals
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @return the area under the curve
+ */
+template<Integrand F>
+double trapezoidal(int n, F &&f, double a, double b) {
+    double h = (b - a) / n;
+
+    double Tn = f(a) + f(b);        // first and last term
+    for (int i = 1; i < n; ++i)      // middle terms
+        Tn += 2 * f(a + i * h);
+    Tn *= h / 2;
+
+    return Tn;
+}
+
+/**
+ * @brief Calculates the integral of f(x) from a to b using the Simpson's ⅓ rule.
+ *
+ * @param n - number of intervals, must be even
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @return the area under the curve
+ */
+template<Integrand F>
+double simpsons(int n, F &&f, double a, double b) {
+    double h = (b - a) / n;
+
+    // odd and even terms in separate passes, so the weight is not picked per node
+    double odd = 0, even = 0;
+    for (int i = 1; i < n; i += 2)
+        odd += f(a + i * h);
+    for (int i = 2; i < n; i += 2)
+        even += f(a + i * h);
+
+    return (f(a) + f(b) + 4 * odd + 2 * even) * h / 3;
+}
+
+/**
+ * @brief Evaluates f at n arbitrary points x into y, batched when the integrand supports it.
+ */
+template<Integrand F>
+void evalPoints(F &&f, const double *x, double *y, std::size_t n) {
+    if constexpr (BatchIntegrand<std::remove_cvref_t<F>>) {
+        f.eval(x, y, n);
+    } else {
+        for (std::size_t k = 0; k < n; ++k)
+            y[k] = f(x[k]);
+    }
+}
+
+/**
+ * @brief Trapezoidal rule for batch integrands.
+ *
+ * The interior nodes are evaluated QUADRATURE_BATCH_SIZE at a time and summed with one weight,
+ * so there is no per-point call and no branch in the loop.
+ */
+template<BatchIntegrand F>
+double trapezoidal(int n, F &&f, double a, double b) {
+    double h = (b - a) / n;
+    double y[QUADRATURE_BATCH_SIZE];
+
+    double ends[2] = {a, b};
+    f.eval(ends, ends, 2);
+
+    double sum = 0;
+    for (long long i = 1; i < n; i += QUADRATURE_BATCH_SIZE) {
+        std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+        evalNodes(f, a, h, i, y, m);
+#pragma omp simd reduction(+:sum)
+        for (std::size_t k = 0; k < m; ++k)
+            sum += y[k];
+    }
+
+    return (ends[0] + ends[1] + 2 * sum) * h / 2;
+}
+
+/**
+ * @brief Simpson's ⅓ rule for batch integrands.
+ *
+ * Batches start on odd nodes, so the weight 4 terms sit at even offsets and the weight 2 terms
+ * at odd offsets of every batch; each is summed in its own strided pass.
+ */
+template<BatchIntegrand F>
+double simpsons(int n, F &&f, double a, double b) {
+    double h = (b - a) / n;
+    double y[QUADRATURE_BATCH_SIZE];
+
+    double ends[2] = {a, b};
+    f.eval(ends, ends, 2);
+
+    double odd = 0, even = 0;
+    for (long long i = 1; i < n; i += QUADRATURE_BATCH_SIZE) {
+        std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+        evalNodes(f, a, h, i, y, m);
+#pragma omp simd reduction(+:odd)
+        for (std::size_t k = 0; k < m; k += 2)
+            odd += y[k];
+#pragma omp simd reduction(+:even)
+        for (std::size_t k = 1; k < m; k += 2)
+            even += y[k];
+    }
+
+    return (ends[0] + ends[1] + 4 * odd + 2 * even) * h / 3;
+}
+
+/**
+ * @brief Trapezoidal rule with a selectable summation strategy, for large n.
+ *
+ * @param n - number of intervals
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param summation - how the samples are added up
+ * @return the area under the curve
+ */
+template<Integrand F>
+double trapezoidal(int n, F &&f, double a, double b, Summation summation) {
+    double h = (b - a) / n;
+    double y[QUADRATURE_BATCH_SIZE];
+    SumAccumulator sum(summation);
+
+    double ends[2] = {a, b};
+    evalPoints(f, ends, ends, 2);
+    ends[0] /= 2;
+    ends[1] /= 2;
+    sum.add(ends, 2);
+
+    for (long long i = 1; i < n; i += QUADRATURE_BATCH_SIZE) {
+        std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+        evalNodes(f, a, h, i, y, m);
+        sum.add(y, m);
+    }
+
+    return sum.total() * h;
+}
+
+/**
+ * Simpson weights of the interior nodes of one batch, which starts on an odd node: 4, 2, 4, 2, ...
+ */
+inline constexpr auto simpsonsBatchWeights = [] {
+    std::array<double, QUADRATURE_BATCH_SIZE> w{};
+    for (std::size_t k = 0; k < QUADRATURE_BATCH_SIZE; ++k)
+        w[k] = k % 2 ? 2 : 4;
+    return w;
+}();
+
+/**
+ * @brief Simpson's ⅓ rule with a selectable summation strategy, for large n.
+ *
+ * The 4-2-4 weights are powers of two, so applying them before the summation is exact.
+ *
+ * @param n - number of intervals, must be even
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @param summation - how the samples are added up
+ * @return the area under the curve
+ */
+template<Integrand F>
+double simpsons(int n, F &&f, double a, double b, Summation summation) {
+    double h = (b - a) / n;
+    double y[QUADRATURE_BATCH_SIZE];
+    SumAccumulator sum(summation);
+
+    double ends[2] = {a, b};
+    evalPoints(f, ends, ends, 2);
+    sum.add(ends, 2);
+
+    for (long long i = 1; i < n; i += QUADRATURE_BATCH_SIZE) {
+        std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+        evalNodes(f, a, h, i, y, m);
+#pragma omp simd
+        for (std::size_t k = 0; k < m; ++k)
+            y[k] *= simpsonsBatchWeights[k];
+        sum.add(y, m);
+    }
+
+    return sum.total() * h / 3;
+}
+
+double trapezoidal(int n, double (*f)(double), double a, double b);
+
+double simpsons(int n, double (*f)(double), double a, double b);
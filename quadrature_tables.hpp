@@ -0,0 +1,197 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <numeric>
+#include <utility>
+#include "quadrature.hpp"
+
+/**
+ * @brief Closed Newton–Cotes weights on [0, 1] for Order + 1 equally spaced nodes.
+ *
+ * w_j = 1/m ∫_0^m Π_{k≠j} (s - k) / (j - k) ds is evaluated in integers at compile time and
+ * rounded to double once, so every table entry is the correctly rounded exact weight.
+ */
+template<int Order>
+constexpr std::array<double, Order + 1> newtonCotesWeights() {
+    static_assert(Order >= 1 && Order <= 8, "integer weights overflow past order 8");
+
+    long long denominator = 1;      // lcm(1, ..., Order + 1) clears the 1 / (i + 1) of the integration
+    for (long long i = 2; i <= Order + 1; ++i)
+        denominator = std::lcm(denominator, i);
+
+    std::array<double, Order + 1> w{};
+    for (int j = 0; j <= Order; ++j) {
+        long long c[Order + 1] = {1};   // coefficients of Π_{k≠j} (s - k), lowest power first
+        long long scale = 1;            // Π_{k≠j} (j - k)
+        int degree = 0;
+        for (int k = 0; k <= Order; ++k) {
+            if (k == j)
+                continue;
+            for (int i = ++degree; i > 0; --i)
+                c[i] = c[i - 1] - k * c[i];
+            c[0] *= -k;
+            scale *= j - k;
+        }
+
+        long long numerator = 0, power = Order;
+        for (int i = 0; i <= degree; ++i, power *= Order)
+            numerator += c[i] * power * (denominator / (i + 1));
+
+        w[j] = (double) numerator / ((double) denominator * Order * scale);
+    }
+
+    return w;
+}
+
+/**
+ * Closed Newton–Cotes rule of a fixed order on the panel [0, 1].
+ */
+template<int Order>
+struct NewtonCotes {
+    static constexpr int order = Order;
+    static constexpr std::array<double, Order + 1> weights = newtonCotesWeights<Order>();
+};
+
+using TrapezoidRule = NewtonCotes<1>;
+using SimpsonRule = NewtonCotes<2>;
+using SimpsonThreeEighthsRule = NewtonCotes<3>;
+using BooleRule = NewtonCotes<4>;
+
+/**
+ * @brief cos(x) by its Taylor series, for tables built at compile time.
+ */
+constexpr double constexprCos(double x) {
+    double term = 1, sum = 1;
+    for (int k = 1; k < 40; ++k) {
+        term *= -x * x / ((2 * k - 1) * (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * @brief Nodes and weights of the N-point Gauss–Legendre rule on [-1, 1], by Newton's method
+ * on P_N from the usual cos(π (i - ¼) / (N + ½)) starting guesses.
+ */
+template<int N>
+constexpr std::pair<std::array<double, N>, std::array<double, N>> gaussLegendreTable() {
+    constexpr double pi = 3.14159265358979323846;
+    std::array<double, N> x{}, w{};
+
+    for (int i = 0; i < (N + 1) / 2; ++i) {
+        double z = constexprCos(pi * (i + 0.75) / (N + 0.5)), dp = 0;
+        for (int iteration = 0; iteration < 100; ++iteration) {
+            double p0 = 1, p1 = z;
+            for (int k = 2; k <= N; ++k) {
+                double p2 = ((2 * k - 1) * z * p1 - (k - 1) * p0) / k;
+                p0 = p1;
+                p1 = p2;
+            }
+            dp = N * (z * p1 - p0) / (z * z - 1);
+
+            double step = p1 / dp;
+            z -= step;
+            if (step == 0 || (step < 0 ? -step : step) < 1e-17)
+                break;
+        }
+
+        x[i] = -z;
+        x[N - 1 - i] = z;
+        w[i] = w[N - 1 - i] = 2 / ((1 - z * z) * dp * dp);
+    }
+
+    if (N % 2)
+        x[N / 2] = 0;
+
+    return {x, w};
+}
+
+/**
+ * N-point Gauss–Legendre rule on [-1, 1].
+ */
+template<int N>
+struct GaussLegendre {
+    static_assert(N >= 1, "at least one node");
+
+    static constexpr auto table = gaussLegendreTable<N>();
+    static constexpr std::array<double, N> nodes = table.first;
+    static constexpr std::array<double, N> weights = table.second;
+};
+
+/**
+ * @brief Weights of the composite rule: Panels panels of Rule glued at their shared end nodes.
+ */
+template<typename Rule, int Panels>
+constexpr std::array<double, Rule::order * Panels + 1> compositeWeights() {
+    std::array<double, Rule::order * Panels + 1> w{};
+    for (int p = 0; p < Panels; ++p)
+        for (int j = 0; j <= Rule::order; ++j)
+            w[p * Rule::order + j] += Rule::weights[j];
+    return w;
+}
+
+/**
+ * @brief y[0] w[0] + ... + y[N-1] w[N-1] as one unrolled chain of multiply-adds.
+ */
+template<std::size_t N, std::size_t... I>
+inline double weightedSum(const std::array<double, N> &w, const double *y, std::index_sequence<I...>) {
+    double sum = 0;
+    ((sum += w[I] * y[I]), ...);
+    return sum;
+}
+
+/**
+ * @brief Composite Newton–Cotes rule with the order and number of panels fixed at compile time.
+ *
+ * The weights of the whole composite rule are a constexpr table, the nodes are evaluated in
+ * one (batched) pass and the weighted sum is unrolled, so there is no loop or weight logic
+ * left at run time.
+ *
+ * @tparam Rule - TrapezoidRule, SimpsonRule, SimpsonThreeEighthsRule, BooleRule or another NewtonCotes order
+ * @tparam Panels - number of panels, the rule uses Rule::order * Panels intervals
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @return the area under the curve
+ */
+template<typename Rule, int Panels, Integrand F>
+double newtonCotes(F &&f, double a, double b) {
+    constexpr int n = Rule::order * Panels;
+    static_assert(n + 1 <= QUADRATURE_BATCH_SIZE, "the nodes must fit one batch");
+    static constexpr auto w = compositeWeights<Rule, Panels>();
+
+    double h = (b - a) / n;
+    double y[n + 1];
+    evalNodes(f, a, h, 0, y, n + 1);
+
+    return weightedSum(w, y, std::make_index_sequence<n + 1>()) * (h * Rule::order);
+}
+
+/**
+ * @brief Composite N-point Gauss–Legendre rule with the number of panels fixed at compile time.
+ *
+ * @param f - the function to integrate
+ * @param a - the lower bound of the integral
+ * @param b - the upper bound of the integral
+ * @return the area under the curve
+ */
+template<int N, int Panels = 1, Integrand F>
+double gaussLegendre(F &&f, double a, double b) {
+    static_assert(N * Panels <= QUADRATURE_BATCH_SIZE, "the nodes must fit one batch");
+    static constexpr auto w = [] {
+        std::array<double, N * Panels> w{};
+        for (int i = 0; i < N * Panels; ++i)
+            w[i] = GaussLegendre<N>::weights[i % N];
+        return w;
+    }();
+
+    double half = (b - a) / (2 * Panels);
+    double x[N * Panels], y[N * Panels];
+    for (int p = 0; p < Panels; ++p)
+        for (int i = 0; i < N; ++i)
+            x[p * N + i] = a + half * (2 * p + 1 + GaussLegendre<N>::nodes[i]);
+    evalPoints(f, x, y, N * Panels);
+
+    return weightedSum(w, y, std::make_index_sequence<N * Panels>()) * half;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+/**
+ * Streaming quantile sketch with relative accuracy (DDSketch, Masson et al., 2019).
+ *
+ * Values are counted in logarithmic buckets, bucket i holding magnitudes in (γ^(i-1), γ^i] with
+ * γ = (1 + α) / (1 - α), so any quantile comes back within a relative error α of the true
+ * sample quantile. Memory grows with the log of the value range, not with the number of
+ * samples, and two sketches merge by adding their counts, so each thread can keep its own.
+ * NaN and infinite values have no bucket; they are counted apart and left out of the quantiles.
+ */
+class QuantileSketch {
+public:
+    /**
+     * @param relativeAccuracy - α, the relative error of the quantiles
+     */
+    explicit QuantileSketch(double relativeAccuracy = 0.005)
+            : gamma((1 + relativeAccuracy) / (1 - relativeAccuracy)), inverseLogGamma(1 / std::log(gamma)) {}
+
+    void add(double x) {
+        if (!std::isfinite(x)) {
+            ++nonFinite;
+            return;
+        }
+        if (std::abs(x) < minMagnitude)
+            ++zero;
+        else if (x > 0)
+            positive.add(index(x), 1);
+        else
+            negative.add(index(-x), 1);
+        ++count;
+    }
+
+    /**
+     * @brief Adds the counts of another sketch with the same accuracy.
+     */
+    void merge(const QuantileSketch &other) {
+        for (std::size_t i = 0; i < other.positive.counts.size(); ++i)
+            if (other.positive.counts[i])
+                positive.add(other.positive.offset + (int) i, other.positive.counts[i]);
+        for (std::size_t i = 0; i < other.negative.counts.size(); ++i)
+            if (other.negative.counts[i])
+                negative.add(other.negative.offset + (int) i, other.negative.counts[i]);
+        zero += other.zero;
+        count += other.count;
+        nonFinite += other.nonFinite;
+    }
+
+    /**
+     * @brief The q-quantile of the values added so far.
+     *
+     * @param q - between 0 and 1, 0.5 is the median
+     * @return the quantile of the finite values, or NAN if there are none
+     */
+    double quantile(double q) const {
+        if (count == 0)
+            return NAN;
+
+        double rank = q * (count - 1);
+        long long seen = 0;
+
+        // most negative first: the negative buckets from the largest magnitude down
+        for (std::size_t i = negative.counts.size(); i-- > 0;)
+            if ((seen += negative.counts[i]) > rank)
+                return -value(negative.offset + (int) i);
+        if ((seen += zero) > rank)
+            return 0;
+        for (std::size_t i = 0; i < positive.counts.size(); ++i)
+            if ((seen += positive.counts[i]) > rank)
+                return value(positive.offset + (int) i);
+
+        return value(positive.offset + (int) positive.counts.size() - 1);
+    }
+
+    /**
+     * @return the number of finite values added
+     */
+    long long getCount() const {
+        return count;
+    }
+
+    /**
+     * @return the number of NaN and infinite values added, which the quantiles ignore
+     */
+    long long getNonFinite() const {
+        return nonFinite;
+    }
+
+private:
+    /**
+     * Bucket counts for a contiguous range of indices starting at offset.
+     */
+    struct Store {
+        std::vector<long long> counts;
+        int offset = 0;
+
+        void add(int i, long long n) {
+            if (counts.empty()) {
+                offset = i;
+                counts.push_back(0);
+            } else if (i < offset) {
+                counts.insert(counts.begin(), offset - i, 0);
+                offset = i;
+            } else if (i >= offset + (int) counts.size()) {
+                counts.resize(i - offset + 1, 0);
+            }
+            counts[i - offset] += n;
+        }
+    };
+
+    static constexpr double minMagnitude = 1e-9;
+
+    int index(double magnitude) const {
+        return (int) std::ceil(std::log(magnitude) * inverseLogGamma);
+    }
+
+    /**
+     * @brief The representative of bucket i: the point with relative error α to both its ends.
+     */
+    double value(int i) const {
+        return 2 * std::pow(gamma, i) / (gamma + 1);
+    }
+
+    double gamma, inverseLogGamma;
+    Store positive, negative;
+    long long zero = 0, count = 0, nonFinite = 0;
+};
@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include "monte_carlo.hpp"
+#include "quantile_sketch.hpp"
+#include "risk.hpp"
+#include "simd_math.hpp"
+
+using namespace std;
+
+/**
+ * @brief Two standard normals for each of the n scenarios from first, draw number `draw`, by Box–Muller.
+ */
+static void normals(uint64_t seed, uint32_t stream, long long first, uint32_t draw, size_t n, double *z1, double *z2) {
+    for (size_t k = 0; k < n; ++k) {
+        uint64_t scenario = first + k;
+        auto bits = philox4x32({(uint32_t) scenario, (uint32_t) (scenario >> 32), draw, stream},
+                               (uint32_t) seed, (uint32_t) (seed >> 32));
+        double u1 = uniformFromBits(bits[0], bits[1]), u2 = uniformFromBits(bits[2], bits[3]);
+        double r = sqrt(-2 * log(1 - u1));
+        z1[k] = r * cos(2 * M_PI * u2);
+        z2[k] = r * sin(2 * M_PI * u2);
+    }
+}
+
+RiskResult simulateNpv(const ProjectCashFlows &flows, const RiskModel &model, long long scenarios, ThreadPool *pool,
+                       uint64_t seed, uint32_t stream) {
+    // the paths are built in year order
+    vector<size_t> order(flows.year.size());
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](size_t i, size_t j) { return flows.year[i] < flows.year[j]; });
+
+    double sp = model.priceVolatility, so = model.opexVolatility;
+    double rho = model.correlation, rhoBar = sqrt(1 - rho * rho);
+
+    size_t chunks = (scenarios + RISK_CHUNK - 1) / RISK_CHUNK;
+    vector<SampleStatistics> stats(chunks);
+    vector<QuantileSketch> sketches(chunks);
+    vector<long long> losses(chunks);
+
+    auto chunk = [&](size_t c) {
+        constexpr size_t B = QUADRATURE_BATCH_SIZE;
+        double logPrice[B], logOpex[B], logV[B], keep[B], npv[B], z1[B], z2[B], price[B], opex[B], discount[B];
+
+        long long end = min<long long>(scenarios, (c + 1) * (long long) RISK_CHUNK);
+        for (long long first = c * (long long) RISK_CHUNK; first < end; first += B) {
+            size_t m = min<long long>(B, end - first);
+
+            normals(seed, stream, first, 0, m, z1, z2);
+            for (size_t k = 0; k < m; ++k) {
+                keep[k] = 1 - (flows.taxRate + model.taxSpread * z1[k]) / 100;
+                logV[k] = -log1p(max(flows.discountRate + model.rateSpread * z2[k], -99.0) / 100);
+                logPrice[k] = logOpex[k] = npv[k] = 0;
+            }
+
+            double previous = order.empty() ? 0 : min(0.0, flows.year[order[0]]);
+            for (size_t j = 0; j < order.size(); ++j) {
+                size_t i = order[j];
+                double year = flows.year[i], dt = year - previous;
+                previous = year;
+
+                if (dt > 0) {
+                    normals(seed, stream, first, j + 1, m, z1, z2);
+                    double sq = sqrt(dt);
+#pragma omp simd
+                    for (size_t k = 0; k < m; ++k) {
+                        logPrice[k] += sp * sq * z1[k] - sp * sp * dt / 2;
+                        logOpex[k] += so * sq * (rho * z1[k] + rhoBar * z2[k]) - so * so * dt / 2;
+                    }
+                }
+
+#pragma omp simd
+                for (size_t k = 0; k < m; ++k)
+                    discount[k] = logV[k] * year;
+                expBatch(logPrice, price, m);
+                expBatch(logOpex, opex, m);
+                expBatch(discount, discount, m);
+
+                double revenue = flows.revenue[i], operatingCost = flows.operatingCost[i], capitalCost = flows.capitalCost[i];
+#pragma omp simd
+                for (size_t k = 0; k < m; ++k)
+                    npv[k] += ((revenue * price[k] - operatingCost * opex[k]) * keep[k] - capitalCost) * discount[k];
+            }
+
+            SampleStatistics batch;
+            batch.count = m;
+            for (size_t k = 0; k < m; ++k)
+                batch.mean += npv[k];
+            batch.mean /= m;
+            for (size_t k = 0; k < m; ++k) {
+                batch.m2 += (npv[k] - batch.mean) * (npv[k] - batch.mean);
+                sketches[c].add(npv[k]);
+                losses[c] += npv[k] < 0;
+            }
+            stats[c].merge(batch);
+        }
+    };
+
+    if (pool)
+        pool->parallelFor(0, chunks, 1, chunk);
+    else
+        for (size_t c = 0; c < chunks; ++c)
+            chunk(c);
+
+    SampleStatistics total;
+    QuantileSketch sketch;
+    long long loss = 0;
+    for (size_t c = 0; c < chunks; ++c) {
+        total.merge(stats[c]);
+        sketch.merge(sketches[c]);
+        loss += losses[c];
+    }
+
+    RiskResult result;
+    result.scenarios = total.count;
+    result.mean = total.mean;
+    result.standardDeviation = total.count > 1 ? sqrt(total.m2 / (total.count - 1)) : 0;
+    result.p10 = sketch.quantile(0.1);
+    result.p50 = sketch.quantile(0.5);
+    result.p90 = sketch.quantile(0.9);
+    result.probabilityOfLoss = total.count ? (double) loss / total.count : 0;
+
+    return result;
+}
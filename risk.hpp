@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "project.hpp"
+#include "thread_pool.hpp"
+
+#define RISK_CHUNK 8192     // scenarios per task, fixed so results do not depend on the thread count
+
+/**
+ * Uncertainty of a project's inputs.
+ *
+ * Revenue and operating cost follow driftless lognormal paths over the years: year-on-year
+ * shocks with the given volatilities, correlated with each other, so a scenario's expected
+ * cash flows match the project's. Tax and discount rates are drawn once per scenario, normally
+ * around the project's own, with standard deviations in percentage points.
+ */
+struct RiskModel {
+    double priceVolatility = 0.15;
+    double opexVolatility = 0.10;
+    double correlation = 0.6;
+    double taxSpread = 1.0;
+    double rateSpread = 1.0;
+};
+
+/**
+ * Summary of a simulated NPV distribution.
+ */
+struct RiskResult {
+    long long scenarios = 0;
+    double mean = 0, standardDeviation = 0;
+    double p10 = 0, p50 = 0, p90 = 0;
+    double probabilityOfLoss = 0;
+};
+
+/**
+ * @brief Monte Carlo distribution of a project's NPV.
+ *
+ * Scenarios are simulated in chunks of RISK_CHUNK on the pool, QUADRATURE_BATCH_SIZE at a time
+ * with the exponentials of the price paths and discount factors vectorized. The normals come
+ * from Philox counters (scenario, draw, stream) under the seed, so every chunk is its own
+ * reproducible stream whichever thread runs it. Each chunk keeps a running mean and variance
+ * and a quantile sketch, merged in chunk order; no samples are stored.
+ *
+ * @param flows - the project's cash flows
+ * @param model - the uncertainty of the inputs
+ * @param scenarios - number of scenarios
+ * @param pool - the pool to run the chunks on, or nullptr to run on the calling thread
+ * @param seed - seed of the random numbers
+ * @param stream - stream of the random numbers, e.g. the project's index, so projects get independent draws
+ * @return mean, standard deviation, P10/P50/P90 and the probability of a negative NPV
+ */
+RiskResult simulateNpv(const ProjectCashFlows &flows, const RiskModel &model, long long scenarios,
+                       ThreadPool *pool = nullptr, std::uint64_t seed = 0, std::uint32_t stream = 0);
+
+template<typename T>
+RiskResult simulateNpv(const Project<T> &project, const RiskModel &model, long long scenarios,
+                       ThreadPool *pool = nullptr, std::uint64_t seed = 0, std::uint32_t stream = 0) {
+    return simulateNpv(cashFlowsOf(project), model, scenarios, pool, seed, stream);
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "quadrature.hpp"
+#include "adaptive_quadrature.hpp"
+
+/**
+ * Trapezoidal refinement with Romberg extrapolation.
+ *
+ * Each refine() halves the step and only evaluates the n new midpoints, reusing every earlier
+ * sample, so reaching n intervals costs n + 1 evaluations in total however many levels were
+ * visited on the way. Every level adds a row to the Richardson tableau
+ * R[k][j] = R[k][j-1] + (R[k][j-1] - R[k-1][j-1]) / (4^j - 1), whose first column is the
+ * trapezoidal rule, second column Simpson's rule and diagonal the Romberg estimate.
+ */
+template<Integrand F>
+class Romberg {
+public:
+    Romberg(F f, double a, double b, int n = 1) : f(f), a(a), b(b), n(n) {
+        double h = (b - a) / n;
+        double y[QUADRATURE_BATCH_SIZE];
+
+        sum = (f(a) + f(b)) / 2;
+        for (long long i = 1; i < n; i += QUADRATURE_BATCH_SIZE) {
+            std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+            evalNodes(this->f, a, h, i, y, m);
+            for (std::size_t k = 0; k < m; ++k)
+                sum += y[k];
+        }
+        evaluations = n + 1;
+
+        tableau.push_back({h * sum});
+    }
+
+    /**
+     * @brief Doubles the number of intervals, evaluating only the new midpoints.
+     *
+     * @return the new trapezoidal estimate
+     */
+    double refine() {
+        double h = (b - a) / n;
+        double y[QUADRATURE_BATCH_SIZE];
+
+        for (long long i = 0; i < n; i += QUADRATURE_BATCH_SIZE) {
+            std::size_t m = std::min<long long>(QUADRATURE_BATCH_SIZE, n - i);
+            evalNodes(f, a + h / 2, h, i, y, m);
+            for (std::size_t k = 0; k < m; ++k)
+                sum += y[k];
+        }
+        evaluations += n;
+        n *= 2;
+
+        const std::vector<double> &previous = tableau.back();
+        std::vector<double> row = {h / 2 * sum};
+        double factor = 1;
+        for (std::size_t j = 1; j <= previous.size(); ++j) {
+            factor *= 4;
+            row.push_back(row[j - 1] + (row[j - 1] - previous[j - 1]) / (factor - 1));
+        }
+        tableau.push_back(row);
+
+        return row[0];
+    }
+
+    /**
+     * @brief Refines until two successive Romberg estimates agree to within the tolerance.
+     *
+     * @param tolerance - the absolute error to reach
+     * @param maxLevels - the most refinements to make
+     * @return the Romberg estimate, the difference of the last two as error estimate and the
+     *         total evaluation count
+     */
+    QuadratureResult integrate(double tolerance, int maxLevels = 20) {
+        for (int level = 0; level < maxLevels && (tableau.size() < 2 || getError() > tolerance); ++level)
+            refine();
+
+        QuadratureResult result;
+        result.value = getRomberg();
+        result.error = getError();
+        result.evaluations = evaluations;
+        result.converged = result.error <= tolerance;
+
+        return result;
+    }
+
+    double getTrapezoidal() const {
+        return tableau.back()[0];
+    }
+
+    /**
+     * Simpson's rule on the current n intervals, available after the first refinement.
+     */
+    double getSimpson() const {
+        return tableau.size() > 1 ? tableau.back()[1] : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    double getRomberg() const {
+        return tableau.back().back();
+    }
+
+    double getError() const {
+        return tableau.size() > 1 ? std::abs(tableau.back().back() - tableau[tableau.size() - 2].back())
+                                  : std::numeric_limits<double>::infinity();
+    }
+
+    int getIntervals() const {
+        return n;
+    }
+
+    long long getEvaluations() const {
+        return evaluations;
+    }
+
+    const std::vector<std::vector<double>> &getTableau() const {
+        return tableau;
+    }
+
+private:
+    F f;
+    double a, b;
+    int n;
+    double sum;
+    long long evaluations;
+    std::vector<std::vector<double>> tableau;
+};
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include "sensitivity.hpp"
+
+using namespace std;
+
+vector<double> Sensitivity::netCashFlow(const ProjectCashFlows &flows) {
+    vector<double> cashFlow(flows.year.size());
+    for (size_t i = 0; i < cashFlow.size(); ++i)
+        cashFlow[i] = (flows.revenue[i] - flows.operatingCost[i]) * (1 - flows.taxRate / 100) - flows.capitalCost[i];
+    return cashFlow;
+}
+
+Sensitivity::Sensitivity(const ProjectCashFlows &flows) : flows(flows), polynomial(flows.year, netCashFlow(flows)) {
+    keep = 1 - flows.taxRate / 100;
+    revenue = operatingCost = capitalCost = 0;
+    for (size_t i = 0; i < flows.year.size(); ++i) {
+        discount.push_back(1 / pow(1 + flows.discountRate / 100, flows.year[i]));
+        revenue += flows.revenue[i] * discount[i];
+        operatingCost += flows.operatingCost[i] * discount[i];
+        capitalCost += flows.capitalCost[i] * discount[i];
+    }
+    npv = (revenue - operatingCost) * keep - capitalCost;
+}
+
+double Sensitivity::npvWithEntry(SensitivityInput series, size_t i, double value) const {
+    switch (series) {
+        case SensitivityInput::Revenue:
+            return npv + (value - flows.revenue[i]) * keep * discount[i];
+        case SensitivityInput::OperatingCost:
+            return npv - (value - flows.operatingCost[i]) * keep * discount[i];
+        case SensitivityInput::CapitalCost:
+            return npv - (value - flows.capitalCost[i]) * discount[i];
+        case SensitivityInput::TaxRate:
+            return (revenue - operatingCost) * (1 - value / 100) - capitalCost;
+        case SensitivityInput::DiscountRate:
+            return polynomial.npv(value).first;
+    }
+    return npv;
+}
+
+double Sensitivity::npvWithScaled(SensitivityInput input, double factor) const {
+    switch (input) {
+        case SensitivityInput::Revenue:
+            return npv + (factor - 1) * revenue * keep;
+        case SensitivityInput::OperatingCost:
+            return npv - (factor - 1) * operatingCost * keep;
+        case SensitivityInput::CapitalCost:
+            return npv - (factor - 1) * capitalCost;
+        case SensitivityInput::TaxRate:
+            return (revenue - operatingCost) * (1 - factor * flows.taxRate / 100) - capitalCost;
+        case SensitivityInput::DiscountRate:
+            return polynomial.npv(factor * flows.discountRate).first;
+    }
+    return npv;
+}
+
+vector<TornadoBar> Sensitivity::tornado(double change) const {
+    static const pair<SensitivityInput, const char *> inputs[] = {
+            {SensitivityInput::Revenue,       "revenue"},
+            {SensitivityInput::OperatingCost, "operating cost"},
+            {SensitivityInput::CapitalCost,   "capital cost"},
+            {SensitivityInput::TaxRate,       "tax rate"},
+            {SensitivityInput::DiscountRate,  "discount rate"}};
+
+    vector<TornadoBar> bars;
+    for (auto &[input, name]: inputs)
+        bars.push_back({input, name, npvWithScaled(input, 1 - change), npvWithScaled(input, 1 + change)});
+    sort(bars.begin(), bars.end(), [](const TornadoBar &x, const TornadoBar &y) {
+        return abs(x.high - x.low) > abs(y.high - y.low);
+    });
+
+    return bars;
+}
+
+ProjectGradient Sensitivity::gradient() const {
+    size_t n = flows.year.size();
+    ProjectGradient g;
+
+    // NPV = sum((revenue - operatingCost) * keep - capitalCost) * v^t, linear in every entry
+    g.npv = npv;
+    for (size_t i = 0; i < n; ++i) {
+        g.npvRevenue.push_back(keep * discount[i]);
+        g.npvOperatingCost.push_back(-keep * discount[i]);
+        g.npvCapitalCost.push_back(-discount[i]);
+    }
+    g.npvTaxRate = -(revenue - operatingCost) / 100;
+    g.npvDiscountRate = polynomial.npv(flows.discountRate).second;
+
+    IrrResult rate = irr(flows.year, netCashFlow(flows));
+    g.irr = rate.rate;
+    g.irrStatus = rate.status;
+    if (rate.status != IrrStatus::Converged)
+        return g;
+
+    // the same partial derivatives at the IRR, each divided by -dNPV/dr there
+    double slope = polynomial.npv(rate.rate).second, revenueAtIrr = 0, operatingCostAtIrr = 0;
+    for (size_t i = 0; i < n; ++i) {
+        double v = 1 / pow(1 + rate.rate / 100, flows.year[i]);
+        g.irrRevenue.push_back(-keep * v / slope);
+        g.irrOperatingCost.push_back(keep * v / slope);
+        g.irrCapitalCost.push_back(v / slope);
+        revenueAtIrr += flows.revenue[i] * v;
+        operatingCostAtIrr += flows.operatingCost[i] * v;
+    }
+    g.irrTaxRate = (revenueAtIrr - operatingCostAtIrr) / 100 / slope;
+
+    return g;
+}
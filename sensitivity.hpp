@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "irr.hpp"
+#include "project.hpp"
+
+/**
+ * The inputs of a project a sensitivity can perturb.
+ */
+enum class SensitivityInput {
+    Revenue,
+    OperatingCost,
+    CapitalCost,
+    TaxRate,
+    DiscountRate
+};
+
+/**
+ * One bar of a tornado chart: the NPV with an input moved down and up by the same fraction.
+ */
+struct TornadoBar {
+    SensitivityInput input;
+    const char *name;
+    double low, high;
+};
+
+/**
+ * Derivatives of a project's NPV and IRR with respect to every input.
+ */
+struct ProjectGradient {
+    double npv = 0, irr = 0;
+    IrrStatus irrStatus = IrrStatus::NoRoot;
+    std::vector<double> npvRevenue, npvOperatingCost, npvCapitalCost;
+    double npvTaxRate = 0, npvDiscountRate = 0;
+    std::vector<double> irrRevenue, irrOperatingCost, irrCapitalCost;
+    double irrTaxRate = 0;
+};
+
+/**
+ * Sensitivity analysis of one project.
+ *
+ * The NPV is linear in every cash-flow entry and in the tax rate, so the discount factors and
+ * the discounted sums of each series are computed once and every perturbation of an entry, a
+ * whole series or the tax rate is an O(1) update of the base NPV. Only a new discount rate
+ * needs another pass over the years, which is a single Horner evaluation.
+ */
+class Sensitivity {
+public:
+    explicit Sensitivity(const ProjectCashFlows &flows);
+
+    template<typename T>
+    explicit Sensitivity(const Project<T> &project) : Sensitivity(cashFlowsOf(project)) {}
+
+    double getNpv() const {
+        return npv;
+    }
+
+    /**
+     * @brief NPV with entry i of one series set to a new value, or with the tax or discount rate set to one.
+     *
+     * @param series - Revenue, OperatingCost or CapitalCost, or TaxRate or DiscountRate
+     * @param i - the entry, ignored for the rates
+     * @param value - its new value, for the rates in percent
+     */
+    double npvWithEntry(SensitivityInput series, std::size_t i, double value) const;
+
+    /**
+     * @brief NPV with one input multiplied by a factor: a whole series, the tax rate or the discount rate.
+     */
+    double npvWithScaled(SensitivityInput input, double factor) const;
+
+    /**
+     * @brief Tornado chart: every input moved by ±change, bars sorted by their swing, widest first.
+     *
+     * @param change - the relative change, 0.1 for ±10%
+     */
+    std::vector<TornadoBar> tornado(double change = 0.1) const;
+
+    /**
+     * @brief NPV and IRR with their derivatives with respect to every entry and rate.
+     *
+     * The partial derivatives have closed forms: (1 - tax) v^t for a revenue entry, its negative
+     * for an operating cost, -v^t for a capital cost and minus the discounted revenue less
+     * operating cost over 100 for the tax rate. dNPV/dr comes out of one Horner pass. The IRR
+     * gradient follows at the IRR by the implicit function theorem, dIRR/dx = -(dNPV/dx) / (dNPV/dr),
+     * so the whole gradient takes O(n) time.
+     */
+    ProjectGradient gradient() const;
+
+private:
+    static std::vector<double> netCashFlow(const ProjectCashFlows &flows);
+
+    ProjectCashFlows flows;
+    CashFlowPolynomial polynomial;      // the after-tax cash flows, for NPVs at other discount rates
+    std::vector<double> discount;
+    double keep;                // 1 - tax rate
+    double revenue, operatingCost, capitalCost;     // discounted sums of the series
+    double npv;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Computes y[i] = e^x[i] for a whole array in a loop the compiler can vectorize.
+ *
+ * The argument is reduced to x = k ln2 + r with |r| <= ln2 / 2, e^r is a degree 13 Taylor
+ * polynomial and 2^k is assembled directly in the exponent bits, so there are no calls or
+ * branches. Relative error is within a few ulp for x in [-708, 709]; inputs are clamped to
+ * that range.
+ *
+ * @param x - the exponents
+ * @param y - the results, may alias x
+ * @param n - number of elements
+ */
+inline void expBatch(const double *x, double *y, std::size_t n) {
+    constexpr double log2e = 1.4426950408889634;
+    constexpr double ln2hi = 6.93147180369123816490e-01;
+    constexpr double ln2lo = 1.90821492927058770002e-10;
+    constexpr double shifter = 0x1.8p52;     // adding it rounds to an integer kept in the low mantissa bits
+
+#pragma omp simd
+    for (std::size_t i = 0; i < n; ++i) {
+        double v = std::clamp(x[i], -708.0, 709.0);
+        double kd = v * log2e + shifter;
+        double k = kd - shifter;
+        double r = (v - k * ln2hi) - k * ln2lo;
+
+        double p = 1.0 / 6227020800.0;
+        p = p * r + 1.0 / 479001600.0;
+        p = p * r + 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+
+        std::uint64_t scale = (std::bit_cast<std::uint64_t>(kd) + 1023) << 52;
+        y[i] = p * std::bit_cast<double>(scale);
+    }
+}
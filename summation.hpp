@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/**
+ * How a quadrature rule adds up its weighted samples.
+ *
+ * Naive:          one running sum (split over vector lanes), error grows like n eps.
+ * Pairwise:       batches are summed as a binary tree, error grows like log(n) eps.
+ * KahanNeumaier:  compensated summation, error stays near eps independent of n.
+ */
+enum class Summation {
+    Naive,
+    Pairwise,
+    KahanNeumaier
+};
+
+/**
+ * Running sum fed in blocks, using the selected summation strategy.
+ */
+class SumAccumulator {
+public:
+    explicit SumAccumulator(Summation mode = Summation::Naive) : mode(mode) {}
+
+    void add(const double *y, std::size_t n) {
+        if (mode == Summation::Naive) {
+            double s = 0;
+#pragma omp simd reduction(+:s)
+            for (std::size_t k = 0; k < n; ++k)
+                s += y[k];
+            sum += s;
+        } else if (mode == Summation::Pairwise) {
+            addPartial(pairwise(y, n), 0);
+        } else {
+            // four interleaved compensated sums hide the latency of the dependency chain
+            double s[4] = {0, 0, 0, 0}, c[4] = {0, 0, 0, 0};
+            std::size_t k = 0;
+            for (; k + 4 <= n; k += 4)
+                for (int lane = 0; lane < 4; ++lane)
+                    neumaier(s[lane], c[lane], y[k + lane]);
+            for (; k < n; ++k)
+                neumaier(s[0], c[0], y[k]);
+            for (int lane = 0; lane < 4; ++lane) {
+                neumaier(sum, compensation, s[lane]);
+                compensation += c[lane];
+            }
+        }
+    }
+
+    double total() const {
+        if (mode == Summation::Pairwise) {
+            double s = 0;
+            for (std::size_t i = partials.size(); i-- > 0;)
+                s += partials[i].value;
+            return s;
+        }
+
+        return sum + compensation;
+    }
+
+private:
+    struct Partial {
+        double value;
+        int level;
+    };
+
+    static void neumaier(double &s, double &c, double y) {
+        double t = s + y;
+        c += std::abs(s) >= std::abs(y) ? (s - t) + y : (y - t) + s;
+        s = t;
+    }
+
+    static double pairwise(const double *y, std::size_t n) {
+        if (n <= 16) {
+            double s = 0;
+            for (std::size_t k = 0; k < n; ++k)
+                s += y[k];
+            return s;
+        }
+
+        std::size_t half = n / 2;
+        return pairwise(y, half) + pairwise(y + half, n - half);
+    }
+
+    /**
+     * Block sums are merged like a binary counter, so equal-sized subtrees are always added
+     * together and the tree over all blocks stays balanced.
+     */
+    void addPartial(double value, int level) {
+        while (!partials.empty() && partials.back().level == level) {
+            value += partials.back().value;
+            partials.pop_back();
+            ++level;
+        }
+        partials.push_back({value, level});
+    }
+
+    Summation mode;
+    double sum = 0;
+    double compensation = 0;
+    std::vector<Partial> partials;
+};
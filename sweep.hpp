@@ -0,0 +1,130 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+#include "quadrature.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Type-erased batch integrand. The erasure costs one indirect call per batch of nodes rather
+ * than per node, and it still satisfies BatchIntegrand, so the rules keep their batched path.
+ */
+class BatchFunction {
+public:
+    BatchFunction() = default;
+
+    template<Integrand F>
+    explicit BatchFunction(F f) : batch([f](const double *x, double *y, std::size_t n) { evalPoints(f, x, y, n); }) {}
+
+    double operator()(double x) const {
+        double y;
+        batch(&x, &y, 1);
+        return y;
+    }
+
+    void eval(const double *x, double *y, std::size_t n) const {
+        batch(x, y, n);
+    }
+
+private:
+    std::function<void(const double *, double *, std::size_t)> batch;
+};
+
+/**
+ * An integral to sweep: the integrand, its interval and the exact value errors are measured against.
+ */
+struct SweepIntegrand {
+    std::string name;
+    BatchFunction f;
+    double a, b;
+    double exact;
+};
+
+/**
+ * A quadrature rule for the sweep. `step` filters n: Simpson's rule uses 2 to skip odd n.
+ */
+struct SweepRule {
+    std::string name;
+    std::function<double(int, const BatchFunction &, double, double)> integrate;
+    int step = 1;
+};
+
+/**
+ * One row of the results table.
+ */
+struct SweepResult {
+    std::string rule;
+    std::string integrand;
+    int n;
+    double value;
+    double absoluteError;
+    double percentError;
+    double seconds;
+};
+
+inline SweepRule trapezoidalRule() {
+    return {"trapezoidal", [](int n, const BatchFunction &f, double a, double b) { return trapezoidal(n, f, a, b); }, 1};
+}
+
+inline SweepRule simpsonsRule() {
+    return {"simpsons", [](int n, const BatchFunction &f, double a, double b) { return simpsons(n, f, a, b); }, 2};
+}
+
+/**
+ * @brief Integrates every (rule, integrand, n) combination on the pool.
+ *
+ * Each combination is its own task, so the work-stealing pool balances the cheap small-n tasks
+ * against the expensive ones. The table is ordered by rule, integrand and n whatever the
+ * scheduling, so it can be passed on to sweepSeries or written out as is.
+ *
+ * @param rules - the rules to apply
+ * @param integrands - the integrals to compute
+ * @param ns - the interval counts, each rule skips the n its step excludes
+ * @param pool - the pool to run on
+ * @return one row per combination
+ */
+inline std::vector<SweepResult> runSweep(const std::vector<SweepRule> &rules, const std::vector<SweepIntegrand> &integrands,
+                                         const std::vector<int> &ns, ThreadPool &pool) {
+    std::vector<SweepResult> results;
+
+    for (auto &rule: rules)
+        for (auto &integrand: integrands)
+            for (int n: ns)
+                if (n % rule.step == 0)
+                    results.push_back({rule.name, integrand.name, n, 0, 0, 0, 0});
+
+    TaskGroup group;
+    std::size_t row = 0;
+    for (auto &rule: rules)
+        for (auto &integrand: integrands)
+            for (int n: ns)
+                if (n % rule.step == 0) {
+                    SweepResult *result = &results[row++];
+                    pool.submit([result, &rule, &integrand, n] {
+                        auto start = std::chrono::steady_clock::now();
+                        result->value = rule.integrate(n, integrand.f, integrand.a, integrand.b);
+                        result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        result->absoluteError = std::abs(result->value - integrand.exact);
+                        result->percentError = result->absoluteError / std::abs(integrand.exact) * 100;
+                    }, &group);
+                }
+    pool.wait(group);
+
+    return results;
+}
+
+/**
+ * @brief Picks the percent error against n for one rule and integrand out of a results table,
+ * in the form the scatter plots take.
+ */
+inline void sweepSeries(const std::vector<SweepResult> &results, const std::string &rule, const std::string &integrand,
+                        std::vector<double> &xs, std::vector<double> &ys) {
+    for (auto &result: results)
+        if (result.rule == rule && result.integrand == integrand) {
+            xs.push_back(result.n);
+            ys.push_back(result.percentError);
+        }
+}
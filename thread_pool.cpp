@@ -0,0 +1,117 @@
+#include "thread_pool.hpp"
+
+using namespace std;
+
+// The pool and worker index the current thread belongs to, null outside any pool.
+static thread_local const ThreadPool *currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = max(threads, 1u);
+
+    for (unsigned i = 0; i < threads; ++i)
+        queues.push_back(make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i)
+        workers.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+void ThreadPool::submit(function<void()> task, TaskGroup *group) {
+    size_t target = currentPool == this ? currentWorker : next++ % queues.size();
+
+    pending++;
+    if (group)
+        group->pending++;
+    {
+        lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back({std::move(task), group});
+    }
+    {
+        // taking the lock orders this notify after a worker's check-then-wait
+        lock_guard<std::mutex> lock(mutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runOne(size_t self) {
+    Task task;
+
+    for (size_t k = 0; k < queues.size() && !task.run; ++k) {
+        Queue &queue = *queues[(self + k) % queues.size()];
+        lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            if (k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+    }
+
+    if (!task.run)
+        return false;
+
+    task.run();
+    // the group may be gone as soon as its count reaches zero, so it is not touched after that
+    bool groupDone = task.group && --task.group->pending == 0;
+    if (--pending == 0 || groupDone)
+        notifyIdle();
+
+    return true;
+}
+
+void ThreadPool::notifyIdle() {
+    lock_guard<std::mutex> lock(mutex);
+    idle.notify_all();
+}
+
+void ThreadPool::work(size_t self) {
+    currentPool = this;
+    currentWorker = self;
+
+    for (;;) {
+        if (runOne(self))
+            continue;
+
+        unique_lock<std::mutex> lock(mutex);
+        if (stopping)
+            return;
+        // re-check under the lock: a submit between runOne and here has already notified
+        bool queued = false;
+        for (auto &queue: queues) {
+            lock_guard<std::mutex> queueLock(queue->mutex);
+            queued = queued || !queue->tasks.empty();
+        }
+        if (!queued)
+            wake.wait(lock);
+    }
+}
+
+void ThreadPool::wait(TaskGroup &group) {
+    if (currentPool == this) {
+        while (group.pending > 0)
+            if (!runOne(currentWorker))
+                this_thread::yield();
+        return;
+    }
+
+    unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [&group] { return group.pending == 0; });
+}
+
+void ThreadPool::wait() {
+    unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending == 0; });
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool.
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to the back of its own deque
+ * and it takes work from the back (newest first, still warm in cache); an idle worker steals
+ * from the front of the other deques (oldest first, usually the biggest pieces). Tasks
+ * submitted from outside the pool are dealt round-robin.
+ */
+class ThreadPool;
+
+/**
+ * Completion counter of one batch of tasks. A task submitted with a group counts towards it
+ * until it finishes, and wait(group) returns once the count is back to zero, so a task can
+ * wait for the work it spawned without also waiting for itself.
+ */
+class TaskGroup {
+    friend class ThreadPool;
+
+    std::atomic<std::size_t> pending{0};
+};
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @param task - the work to run
+     * @param group - the batch the task belongs to, if it is to be waited for with wait(group)
+     */
+    void submit(std::function<void()> task, TaskGroup *group = nullptr);
+
+    /**
+     * @brief Blocks until every task of the group has finished. Called from a worker, it runs
+     * queued tasks while it waits instead of blocking the worker.
+     */
+    void wait(TaskGroup &group);
+
+    /**
+     * @brief Blocks until every submitted task has finished. Only for threads outside the pool:
+     * inside a task it would be waiting for that task too, use a TaskGroup there.
+     */
+    void wait();
+
+    unsigned size() const {
+        return workers.size();
+    }
+
+    /**
+     * @brief Runs body(i) for every i in [begin, end), in chunks of `grain` indices, and
+     * returns when all are done.
+     */
+    template<typename Body>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Body body) {
+        TaskGroup group;
+        grain = std::max<std::size_t>(grain, 1);
+        for (std::size_t first = begin; first < end; first += grain) {
+            std::size_t last = std::min(first + grain, end);
+            submit([=] {
+                for (std::size_t i = first; i < last; ++i)
+                    body(i);
+            }, &group);
+        }
+        wait(group);
+    }
+
+private:
+    struct Task {
+        std::function<void()> run;
+        TaskGroup *group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool runOne(std::size_t self);
+
+    void work(std::size_t self);
+
+    void notifyIdle();
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, idle;
+    std::atomic<std::size_t> pending{0}, next{0};
+    bool stopping = false;
+};